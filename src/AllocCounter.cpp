@@ -0,0 +1,48 @@
+#include "AllocCounter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// replaces the global operator new and delete. The array and nothrow forms
+// forward to these by default, so every allocation is counted once.
+namespace {
+std::atomic<std::uint64_t> count{0};
+
+void* allocate(std::size_t n)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* allocate(std::size_t n, std::align_val_t al)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t a = static_cast<std::size_t>(al);
+    n = (n + a - 1) / a * a;                       // aligned_alloc wants a multiple
+#if defined(_WIN32)
+    if (void* p = _aligned_malloc(n ? n : a, a)) return p;
+#else
+    if (void* p = std::aligned_alloc(a, n ? n : a)) return p;
+#endif
+    throw std::bad_alloc();
+}
+
+void release(void* p, std::align_val_t)
+{
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+}
+
+std::uint64_t alloccount::allocations() { return count.load(std::memory_order_relaxed); }
+
+void* operator new(std::size_t n)                       { return allocate(n); }
+void* operator new(std::size_t n, std::align_val_t a)   { return allocate(n, a); }
+void  operator delete(void* p) noexcept                 { std::free(p); }
+void  operator delete(void* p, std::size_t) noexcept    { std::free(p); }
+void  operator delete(void* p, std::align_val_t a) noexcept              { release(p, a); }
+void  operator delete(void* p, std::size_t, std::align_val_t a) noexcept { release(p, a); }
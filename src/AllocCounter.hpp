@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+
+// counts calls to the global operator new, to check that steady-state
+// loops do not allocate. Defined only in binaries that link
+// src/AllocCounter.cpp: with -DPACMAN_COUNT_ALLOCS=ON, and the allocation
+// test.
+namespace alloccount {
+
+std::uint64_t allocations();           // so far, across all threads
+
+}
@@ -0,0 +1,81 @@
+#include "AssetArchive.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#   include <fstream>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+AssetArchive::~AssetArchive()
+{
+    close();
+}
+
+bool AssetArchive::open(const std::string& path)
+{
+    close();
+
+#if defined(_WIN32)
+    // no mmap here: read the pack in one go
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    size_ = std::size_t(in.tellg());
+    auto* buf = new unsigned char[size_];
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(buf), std::streamsize(size_));
+    base_ = buf;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) { ::close(fd); return false; }
+    size_ = std::size_t(st.st_size);
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) { size_ = 0; return false; }
+    base_ = static_cast<const unsigned char*>(p);
+#endif
+
+    Header h;
+    if (size_ < sizeof h) { close(); return false; }
+    std::memcpy(&h, base_, sizeof h);
+    if (h.magic != MAGIC || h.version != VERSION ||
+        size_ < sizeof h + std::size_t(h.count) * sizeof(Entry)) {
+        close();
+        return false;
+    }
+    entries_ = reinterpret_cast<const Entry*>(base_ + sizeof h);
+    count_   = h.count;
+    for (std::uint32_t i = 0; i < count_; ++i)
+        if (entries_[i].offset + entries_[i].size > size_) { close(); return false; }
+    return true;
+}
+
+void AssetArchive::close()
+{
+    if (!base_) return;
+#if defined(_WIN32)
+    delete[] base_;
+#else
+    ::munmap(const_cast<unsigned char*>(base_), size_);
+#endif
+    base_ = nullptr;
+    size_ = 0;
+    entries_ = nullptr;
+    count_ = 0;
+}
+
+const AssetArchive::Entry* AssetArchive::find(std::string_view name) const
+{
+    for (std::uint32_t i = 0; i < count_; ++i) {
+        const char* n = entries_[i].name;
+        if (name == std::string_view(n, std::size_t(std::find(n, n + NAME, '\0') - n)))
+            return &entries_[i];
+    }
+    return nullptr;
+}
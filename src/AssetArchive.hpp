@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// single-file resource pack, memory-mapped read-only.
+//
+//   Header | Entry[count] | payloads (16-byte aligned)
+//
+// Sounds are stored as interleaved int16 PCM, textures as raw RGBA8 and
+// everything else (fonts, levels) verbatim, so nothing is decoded at runtime.
+class AssetArchive {
+public:
+    enum class Kind : std::uint32_t { Raw, Pcm16, Rgba8 };
+
+    static constexpr std::uint32_t MAGIC   = 0x4B504D50;   // "PMPK"
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::size_t   NAME    = 56;
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t count;
+        std::uint32_t reserved;
+    };
+
+    struct Entry {
+        char          name[NAME];   // resource path, e.g. "resources/audio/start.wav"
+        Kind          kind;
+        std::uint32_t a;            // Pcm16: channels,    Rgba8: width
+        std::uint64_t b;            // Pcm16: sample rate, Rgba8: height
+        std::uint64_t offset;       // from the start of the file
+        std::uint64_t size;         // bytes
+    };
+
+    static_assert(sizeof(Header) == 16 && sizeof(Entry) == 88, "on-disk layout");
+
+    AssetArchive() = default;
+    ~AssetArchive();
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    bool open(const std::string& path);      // false if missing or malformed
+    bool isOpen() const { return base_ != nullptr; }
+
+    const Entry* find(std::string_view name) const;
+    const void*  data(const Entry& e) const { return base_ + e.offset; }
+
+private:
+    void close();
+
+    const unsigned char* base_{nullptr};
+    std::size_t          size_{0};
+    const Entry*         entries_{nullptr};
+    std::uint32_t        count_{0};
+};
@@ -0,0 +1,69 @@
+#include "AssetManager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// time until every asset is usable: loose files vs the packed archive.
+// For a truly cold cache drop the page cache before each run and pass --runs 1.
+// usage: AssetBench [--runs N] [--archive FILE]
+namespace {
+double startupMs(const std::string& archive)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        AssetManager assets(archive);
+        assets.waitAll();
+        assets.texture(TextureId::Tiles);
+        assets.font(FontId::Hud);
+        assets.text("resources/levels/level1.txt");
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+}
+
+int main(int argc, char** argv)
+{
+    int         runs    = 20;
+    std::string archive = AssetManager::DEFAULT_ARCHIVE;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--archive") && i + 1 < argc)
+            archive = argv[++i];
+        else {
+            std::cerr << "usage: " << argv[0] << " [--runs N] [--archive FILE]\n";
+            return 1;
+        }
+    }
+
+    {
+        AssetManager probe(archive);
+        if (!probe.packed()) {
+            std::cerr << "ERROR: cannot open archive " << archive << '\n';
+            return 1;
+        }
+    }
+
+    // the first run of each kind is the coldest one this process sees
+    std::vector<double> loose, packed;
+    for (int r = 0; r < runs; ++r) {
+        loose.push_back(startupMs(""));
+        packed.push_back(startupMs(archive));
+    }
+
+    std::cout << "            first ms   median ms\n"
+              << "loose     " << std::setw(10) << loose[0]  << std::setw(12) << median(loose)  << '\n'
+              << "packed    " << std::setw(10) << packed[0] << std::setw(12) << median(packed) << '\n'
+              << "speedup   " << std::setw(10) << loose[0] / packed[0]
+              << std::setw(12) << median(loose) / median(packed) << '\n';
+}
@@ -0,0 +1,194 @@
+#include "AssetManager.hpp"
+#include "SfmlCompat.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+
+namespace {
+// slot order: sounds, textures, fonts
+constexpr const char* PATHS[] = {
+    "resources/audio/start.wav",
+    "resources/audio/siren.wav",
+    "resources/audio/death.wav",
+    "resources/audio/gameover.wav",
+    "resources/audio/win.wav",
+    "resources/audio/munch1.wav",
+    "resources/audio/munch2.wav",
+    "resources/textures/tiles.png",
+    "resources/fonts/PressStart2P.ttf",
+};
+
+double msSince(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+bool loadPcm(sf::SoundBuffer& buf, const void* data, std::uint64_t bytes,
+             unsigned channels, unsigned rate)
+{
+    auto* samples = static_cast<const std::int16_t*>(data);
+    std::uint64_t count = bytes / sizeof(std::int16_t);
+#if SFML_VERSION_MAJOR >= 3
+    std::vector<sf::SoundChannel> map = channels == 1
+        ? std::vector<sf::SoundChannel>{sf::SoundChannel::Mono}
+        : std::vector<sf::SoundChannel>{sf::SoundChannel::FrontLeft, sf::SoundChannel::FrontRight};
+    return buf.loadFromSamples(samples, count, channels, rate, map);
+#else
+    return buf.loadFromSamples(samples, count, channels, rate);
+#endif
+}
+
+bool uploadRgba(sf::Texture& tex, const void* pixels, unsigned w, unsigned h)
+{
+#if SFML_VERSION_MAJOR >= 3
+    if (!tex.resize({w, h})) return false;
+#else
+    if (!tex.create(w, h)) return false;
+#endif
+    tex.update(static_cast<const std::uint8_t*>(pixels));
+    return true;
+}
+}
+
+AssetManager::AssetManager(const std::string& archive)
+: start_(std::chrono::steady_clock::now())
+, pool_(unsigned(std::min<std::size_t>(ASSETS, std::max(1u, std::thread::hardware_concurrency()))))
+{
+    static_assert(std::size(PATHS) == ASSETS, "one path per asset");
+    for (std::size_t i = 0; i < ASSETS; ++i) {
+        slots_[i].path   = PATHS[i];
+        slots_[i].loaded = slots_[i].done.get_future().share();
+    }
+    archive_.open(archive);
+
+    loader_ = std::thread([this]{
+        pool_.parallelFor(ASSETS, 1, [this](std::size_t b, std::size_t e){
+            for (std::size_t i = b; i < e; ++i) load(i);
+        });
+    });
+}
+
+AssetManager::~AssetManager()
+{
+    loader_.join();
+}
+
+void AssetManager::loadLoose(std::size_t i)
+{
+    Slot& s = slots_[i];
+    if (i < SOUNDS)
+        s.ok = sounds_[i].loadFromFile(s.path);
+    else if (i < SOUNDS + TEXTURES)
+        s.ok = images_[i - SOUNDS].loadFromFile(s.path);
+    else {
+        std::size_t f = i - SOUNDS - TEXTURES;
+        std::ifstream in(s.path, std::ios::binary);
+        fontFile_[f].assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        fontData_[f] = fontFile_[f].data();
+        fontSize_[f] = fontFile_[f].size();
+        s.ok = !fontFile_[f].empty();
+    }
+}
+
+void AssetManager::loadPacked(std::size_t i)
+{
+    using Kind = AssetArchive::Kind;
+    Slot& s = slots_[i];
+    const AssetArchive::Entry* e = archive_.find(s.path);
+    if (!e) { s.ok = false; return; }
+
+    if (i < SOUNDS)
+        s.ok = e->kind == Kind::Pcm16 &&
+               loadPcm(sounds_[i], archive_.data(*e), e->size, e->a, unsigned(e->b));
+    else if (i < SOUNDS + TEXTURES) {
+        s.ok = e->kind == Kind::Rgba8;
+        rgba_[i - SOUNDS] = e;
+    } else {
+        std::size_t f = i - SOUNDS - TEXTURES;
+        fontData_[f] = archive_.data(*e);
+        fontSize_[f] = std::size_t(e->size);
+        s.ok = e->size > 0;
+    }
+}
+
+void AssetManager::load(std::size_t i)
+{
+    Slot& s = slots_[i];
+    auto t0 = std::chrono::steady_clock::now();
+
+    if (archive_.isOpen()) loadPacked(i);
+    else                   loadLoose(i);
+    if (!s.ok)
+        std::cerr << "ERROR: cannot load " << s.path << '\n';
+
+    s.ms       = msSince(t0);
+    s.finished = msSince(start_);
+    s.done.set_value();
+}
+
+AssetHandle<sf::SoundBuffer> AssetManager::sound(SoundId id) const
+{
+    std::size_t i = std::size_t(id);
+    return {sounds_[i], slots_[i].loaded};
+}
+
+const sf::Texture& AssetManager::texture(TextureId id)
+{
+    std::size_t i = std::size_t(id);
+    slots_[SOUNDS + i].loaded.wait();
+    std::call_once(uploaded_[i], [&]{
+        if (!slots_[SOUNDS + i].ok) return;
+        const AssetArchive::Entry* e = rgba_[i];
+        bool ok = e ? uploadRgba(textures_[i], archive_.data(*e), e->a, unsigned(e->b))
+                    : textures_[i].loadFromImage(images_[i]);
+        if (!ok)
+            std::cerr << "ERROR: cannot upload " << slots_[SOUNDS + i].path << '\n';
+    });
+    return textures_[i];
+}
+
+const sf::Font& AssetManager::font(FontId id)
+{
+    std::size_t i = std::size_t(id);
+    slots_[SOUNDS + TEXTURES + i].loaded.wait();
+    std::call_once(opened_[i], [&]{
+        if (fontSize_[i] && !FONT_OPEN_MEM(fonts_[i], fontData_[i], fontSize_[i]))
+            std::cerr << "ERROR: cannot open " << slots_[SOUNDS + TEXTURES + i].path << '\n';
+    });
+    return fonts_[i];
+}
+
+std::string AssetManager::text(const char* path) const
+{
+    if (archive_.isOpen())
+        if (const AssetArchive::Entry* e = archive_.find(path)) {
+            auto* p = static_cast<const char*>(archive_.data(*e));
+            return std::string(p, p + e->size);
+        }
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void AssetManager::waitAll() const
+{
+    for (auto& s : slots_) s.loaded.wait();
+}
+
+void AssetManager::report(std::ostream& os) const
+{
+    waitAll();
+    double slowest = 0, sum = 0, wall = 0;
+    for (auto& s : slots_) {
+        os << std::setw(36) << std::left << s.path
+           << std::setw(10) << std::right << std::fixed << std::setprecision(2) << s.ms << " ms"
+           << (s.ok ? "" : "  FAILED") << '\n';
+        slowest = std::max(slowest, s.ms);
+        sum += s.ms;
+        wall = std::max(wall, s.finished);
+    }
+    os << "assets: slowest " << slowest << " ms, sum " << sum
+       << " ms, all ready after " << wall << " ms on " << pool_.size() << " threads"
+       << (packed() ? " (packed archive)" : " (loose files)") << '\n';
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
+#include <array>
+#include <chrono>
+#include <future>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AssetArchive.hpp"
+#include "WorkerPool.hpp"
+
+enum class SoundId   { Start, Siren, Death, GameOver, Win, Munch1, Munch2, Count };
+enum class TextureId { Tiles, Count };
+enum class FontId    { Hud, Count };
+
+// handle to an asset that may still be loading
+template<class T>
+class AssetHandle {
+public:
+    AssetHandle(const T& obj, std::shared_future<void> loaded) : obj_(&obj), loaded_(std::move(loaded)) {}
+
+    const T& get() const { loaded_.wait(); return *obj_; }     // blocks until loaded
+    bool ready() const { return loaded_.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+    const std::shared_future<void>& future() const { return loaded_; }
+
+private:
+    const T* obj_;
+    std::shared_future<void> loaded_;
+};
+
+// loads every texture, sound buffer and font in parallel on a WorkerPool,
+// starting in the constructor. Sound buffers are complete on the worker;
+// images and font files are read there and turned into sf::Texture/sf::Font
+// by the first texture()/font() call, which must come from the render thread.
+//
+// When the packed archive built by PacManPack is present everything comes
+// from its memory map instead: PCM and RGBA are used as stored and the font
+// is opened in place, with no per-file open and no PNG/WAV decode.
+class AssetManager {
+public:
+    static constexpr const char* DEFAULT_ARCHIVE = "resources/assets.pak";
+
+    explicit AssetManager(const std::string& archive = DEFAULT_ARCHIVE);
+    ~AssetManager();
+
+    AssetManager(const AssetManager&) = delete;
+    AssetManager& operator=(const AssetManager&) = delete;
+
+    AssetHandle<sf::SoundBuffer> sound(SoundId id) const;
+    const sf::Texture&           texture(TextureId id);
+    const sf::Font&              font(FontId id);
+    std::string                  text(const char* path) const;   // raw file, e.g. a level
+
+    bool packed() const { return archive_.isOpen(); }
+
+    void waitAll() const;
+    void report(std::ostream& os) const;   // per-asset and total load time
+
+private:
+    struct Slot {
+        const char*                path;
+        std::promise<void>         done;
+        std::shared_future<void>   loaded;
+        double                     ms{0};         // decode time
+        double                     finished{0};   // since construction
+        bool                       ok{false};
+    };
+
+    static constexpr std::size_t SOUNDS   = std::size_t(SoundId::Count);
+    static constexpr std::size_t TEXTURES = std::size_t(TextureId::Count);
+    static constexpr std::size_t FONTS    = std::size_t(FontId::Count);
+    static constexpr std::size_t ASSETS   = SOUNDS + TEXTURES + FONTS;
+
+    void load(std::size_t index);
+
+    std::array<Slot, ASSETS> slots_;
+
+    void loadLoose(std::size_t index);
+    void loadPacked(std::size_t index);
+
+    AssetArchive archive_;
+
+    std::array<sf::SoundBuffer, SOUNDS>   sounds_;
+    std::array<sf::Image, TEXTURES>       images_;       // loose files only
+    std::array<const AssetArchive::Entry*, TEXTURES> rgba_{};   // packed only
+    std::array<sf::Texture, TEXTURES>     textures_;
+    std::array<std::once_flag, TEXTURES>  uploaded_;
+    std::array<std::vector<char>, FONTS>  fontFile_;     // loose files only
+    std::array<const void*, FONTS>        fontData_{};
+    std::array<std::size_t, FONTS>        fontSize_{};
+    std::array<sf::Font, FONTS>           fonts_;
+    std::array<std::once_flag, FONTS>     opened_;
+
+    std::chrono::steady_clock::time_point start_;
+
+    WorkerPool  pool_;
+    std::thread loader_;
+};
@@ -0,0 +1,86 @@
+#include "AudioMixer.hpp"
+#include <algorithm>
+
+AudioMixer::AudioMixer(const AssetManager& assets)
+: accum_(FRAMES * CHANNELS)
+, out_(FRAMES * CHANNELS)
+{
+    for (std::size_t i = 0; i < sources_.size(); ++i) {
+        const sf::SoundBuffer& buf = assets.sound(SoundId(i)).get();
+        Source& s = sources_[i];
+        s.channels = std::max(1u, buf.getChannelCount());
+        s.pcm      = buf.getSamples();
+        s.frames   = buf.getSampleCount() / s.channels;
+        s.step     = (std::uint64_t(buf.getSampleRate()) << 32) / RATE;
+    }
+
+#if SFML_VERSION_MAJOR >= 3
+    initialize(CHANNELS, RATE, {sf::SoundChannel::FrontLeft, sf::SoundChannel::FrontRight});
+#else
+    initialize(CHANNELS, RATE);
+#endif
+}
+
+AudioMixer::~AudioMixer()
+{
+    sf::SoundStream::stop();     // join the streaming thread before members go
+}
+
+// audio thread
+void AudioMixer::apply(const SoundEvent& ev)
+{
+    const int src = int(ev.sound);
+    switch (ev.op) {
+        case SoundEvent::Op::Play: {
+            // first idle voice, otherwise steal round-robin
+            auto it = std::find_if(voices_.begin(), voices_.end(), [](const Voice& v){ return v.source < 0; });
+            Voice& v = it != voices_.end() ? *it : voices_[nextVoice_++ % VOICES];
+            v.source = src;
+            v.pos    = 0;
+            v.gain   = ev.volume * 256 / 100;
+            v.loop   = ev.loop;
+            break;
+        }
+        case SoundEvent::Op::Stop:
+            for (auto& v : voices_) if (v.source == src) v.source = -1;
+            break;
+        case SoundEvent::Op::StopAll:
+            for (auto& v : voices_) v.source = -1;
+            break;
+    }
+}
+
+// audio thread: drain the queue, then mix one chunk
+bool AudioMixer::onGetData(Chunk& data)
+{
+    SoundEvent ev;
+    while (events_.pop(ev)) apply(ev);
+
+    std::fill(accum_.begin(), accum_.end(), 0);
+    for (auto& v : voices_) {
+        if (v.source < 0) continue;
+        const Source& s = sources_[v.source];
+        if (!s.pcm || s.frames == 0) { v.source = -1; continue; }
+
+        for (int f = 0; f < FRAMES; ++f) {
+            std::uint64_t frame = v.pos >> 32;
+            if (frame >= s.frames) {
+                if (!v.loop) { v.source = -1; break; }
+                v.pos -= s.frames << 32;
+                frame = v.pos >> 32;
+            }
+            const std::int16_t* p = s.pcm + frame * s.channels;
+            int l = p[0], r = s.channels > 1 ? p[1] : p[0];
+            accum_[f*2+0] += l * v.gain >> 8;
+            accum_[f*2+1] += r * v.gain >> 8;
+            v.pos += s.step;
+        }
+    }
+
+    for (std::size_t i = 0; i < accum_.size(); ++i)
+        out_[i] = std::int16_t(std::clamp(accum_[i], -32768, 32767));
+
+    data.samples     = out_.data();
+    data.sampleCount = out_.size();
+    return true;                                  // endless stream, silence when idle
+}
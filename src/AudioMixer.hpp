@@ -0,0 +1,69 @@
+#pragma once
+#include <SFML/Audio.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "AssetManager.hpp"
+#include "SpscRing.hpp"
+
+// fixed-size command from the game thread to the mixer
+struct SoundEvent {
+    enum class Op : std::uint8_t { Play, Stop, StopAll };
+
+    Op           op{Op::Play};
+    SoundId      sound{SoundId::Start};
+    bool         loop{false};
+    std::uint8_t volume{100};     // percent
+};
+
+// one sf::SoundStream that mixes every game sound in software on the audio
+// backend's streaming thread. The game thread only pushes SoundEvents into a
+// lock-free SPSC ring, so it never touches OpenAL source state.
+class AudioMixer : public sf::SoundStream {
+public:
+    static constexpr unsigned RATE     = 44100;
+    static constexpr unsigned CHANNELS = 2;
+    static constexpr int      VOICES   = 16;
+    static constexpr int      FRAMES   = 512;    // per chunk, ~12 ms
+
+    explicit AudioMixer(const AssetManager& assets);
+    ~AudioMixer() override;
+
+    // game thread; a full queue drops the event rather than block
+    void playSound(SoundId id, std::uint8_t volume = 100, bool loop = false) { send({SoundEvent::Op::Play, id, loop, volume}); }
+    void stopSound(SoundId id) { send({SoundEvent::Op::Stop, id}); }
+    void stopAllSounds()       { send({SoundEvent::Op::StopAll}); }
+
+    std::uint64_t dropped() const { return dropped_; }
+
+protected:
+    bool onGetData(Chunk& data) override;
+    void onSeek(sf::Time) override {}
+
+private:
+    struct Source {
+        const std::int16_t* pcm{nullptr};
+        std::uint64_t       frames{0};
+        unsigned            channels{1};
+        std::uint64_t       step{0};         // source frames per output frame, 32.32 fixed point
+    };
+
+    struct Voice {
+        int           source{-1};            // -1 = idle
+        std::uint64_t pos{0};                // 32.32 fixed point frame position
+        int           gain{0};               // 0..256
+        bool          loop{false};
+    };
+
+    void send(const SoundEvent& ev) { if (!events_.push(ev)) ++dropped_; }
+    void apply(const SoundEvent& ev);
+
+    std::array<Source, std::size_t(SoundId::Count)> sources_;
+    std::array<Voice, VOICES>                       voices_;
+    int                                             nextVoice_{0};
+
+    SpscRing<SoundEvent, 256>  events_;
+    std::uint64_t              dropped_{0};
+    std::vector<std::int32_t>  accum_;
+    std::vector<std::int16_t>  out_;
+};
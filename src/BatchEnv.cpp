@@ -0,0 +1,155 @@
+#include "BatchEnv.hpp"
+#include "Ghost.hpp"
+#include "Movement.hpp"
+#include <algorithm>
+#include <cstring>
+
+BatchEnv::BatchEnv(const std::string& levelFile, int envs, std::uint64_t seed, unsigned threads)
+: level_(Level::open(levelFile))
+, envs_(envs)
+, mazeW_(level_.width() * TILE_FX)
+, pool_(threads)
+{
+    words_ = level_.bitboardWords();
+
+    const std::size_t n = std::size_t(envs), ng = n * GHOSTS;
+    px_.resize(n); py_.resize(n); pdir_.resize(n); pnext_.resize(n); pface_.resize(n); ptp_.resize(n);
+    gx_.resize(ng); gy_.resize(ng); gdir_.resize(ng); gtp_.resize(ng);
+    pellets_.resize(n * words_);
+    pelletsLeft_.resize(n); score_.resize(n); lives_.resize(n);
+    done_.resize(n); episodes_.assign(n, 0); rng_.resize(n);
+
+    SplitMix64 seeder{seed};
+    for (std::size_t e = 0; e < n; ++e) {
+        rng_[e] = seeder();
+        resetEnv(e);
+    }
+}
+
+std::uint64_t BatchEnv::episodes() const
+{
+    std::uint64_t total = 0;
+    for (auto c : episodes_) total += c;
+    return total;
+}
+
+void BatchEnv::resetPositions(std::size_t e)
+{
+    const Fixed2 start = tileCenter(level_.playerStart());
+    px_[e] = start.x; py_[e] = start.y;
+    pdir_[e] = pnext_[e] = Dir::None;
+    pface_[e] = Dir::Right;
+    ptp_[e] = 0;
+    for (int k = 0; k < GHOSTS; ++k) {
+        std::size_t i = e * GHOSTS + k;
+        const Fixed2 g = tileCenter(level_.ghostStart(k));
+        gx_[i] = g.x;
+        gy_[i] = g.y;
+        gdir_[i] = Dir::Left;
+        gtp_[i] = 0;
+    }
+}
+
+void BatchEnv::resetEnv(std::size_t e)
+{
+    std::memcpy(&pellets_[e * words_], level_.initialPellets(), words_ * sizeof(std::uint64_t));
+    pelletsLeft_[e] = unsigned(level_.initialPelletCount());
+    score_[e] = 0;
+    lives_[e] = Simulation::START_LIVES;
+    done_[e]  = 0;
+    resetPositions(e);
+}
+
+void BatchEnv::step(const Dir* actions)
+{
+    pool_.parallelFor(std::size_t(envs_), CHUNK,
+                      [this, actions](std::size_t b, std::size_t e){ stepRange(b, e, actions); });
+}
+
+void BatchEnv::stepRange(std::size_t b, std::size_t e, const Dir* actions)
+{
+    const Level& lvl = level_;
+
+    for (std::size_t i = b; i < e; ++i)
+        if (done_[i]) resetEnv(i);
+
+    // player: pellet, steering, wrap and teleport
+    for (std::size_t i = b; i < e; ++i) {
+        Fixed2 p{px_[i], py_[i]};
+        Vec2i t = tileOf(p);
+        std::size_t bit = lvl.bit(t.x, t.y);
+        std::uint64_t& word = pellets_[i * words_ + (bit >> 6)];
+        std::uint64_t  mask = 1ull << (bit & 63);
+        if (word & mask) {
+            word &= ~mask;
+            --pelletsLeft_[i];
+            score_[i] += Simulation::PELLET_SCORE;
+        }
+        if (actions[i] != Dir::None) pnext_[i] = actions[i];
+        steerAndMove(lvl, p, pdir_[i], pnext_[i]);
+        if (pdir_[i] != Dir::None) pface_[i] = pdir_[i];
+        bool tp = ptp_[i];
+        wrapAndTeleport(lvl, p, tp);
+        ptp_[i] = tp;
+        px_[i] = p.x; py_[i] = p.y;
+    }
+
+    // ghost decisions: branchy, only a few ghosts per tick need one. Ghost
+    // k of every env behaves as ghostai::kindOf(k), so each k is one batch
+    // of one policy; an env's own draws still come in ghost order.
+    static_assert(GHOSTS == ghostai::KINDS);
+    const std::size_t gb = b * GHOSTS, ge = e * GHOSTS;
+    for (std::size_t k = 0; k < GHOSTS; ++k)
+        ghostai::withPolicy(ghostai::kindOf(k), [&]<class Policy>(Policy) {
+            for (std::size_t i = gb + k; i < ge; i += GHOSTS) {
+                Fixed2 p{gx_[i], gy_[i]};
+                if (!Ghost::needsDecision(lvl, p, gdir_[i])) continue;
+                const Dir along = Ghost::corridorHeading(lvl, p, gdir_[i]);
+                if (along != Dir::None) { gdir_[i] = along; continue; }
+                const std::size_t env = i / GHOSTS;
+                const ghostai::Hunt hunt{tileOf(Fixed2{px_[env], py_[env]}), pface_[env]};
+                const Vec2i target = Policy::target(lvl, hunt, tileOf(p));
+                SplitMix64 rng{rng_[env]};
+                gdir_[i] = Ghost::decide(lvl, p, gdir_[i], tileCenter(target), rng, Policy::WANDER);
+                rng_[env] = rng.state;
+            }
+        });
+
+    // ghost movement and wrap: straight-line arithmetic over the SoA arrays
+    std::int32_t* __restrict gx = gx_.data();
+    std::int32_t* __restrict gy = gy_.data();
+    const Dir* __restrict gd = gdir_.data();
+    const std::int32_t W = mazeW_;
+    for (std::size_t i = gb; i < ge; ++i) {
+        std::int32_t sx = SPEED_FX * (int(gd[i] == Dir::Right) - int(gd[i] == Dir::Left));
+        std::int32_t sy = SPEED_FX * (int(gd[i] == Dir::Down)  - int(gd[i] == Dir::Up));
+        std::int32_t x  = gx[i] + sx;
+        x += W * (int(x < 0) - int(x > W));
+        gx[i] = x;
+        gy[i] += sy;
+    }
+
+    for (std::size_t i = gb; i < ge; ++i) {
+        Fixed2 p{gx_[i], gy_[i]};
+        bool tp = gtp_[i];
+        teleport(lvl, p, tp);
+        gtp_[i] = tp;
+        gx_[i] = p.x; gy_[i] = p.y;
+    }
+
+    // collision: squared distance against every ghost of the env
+    for (std::size_t i = b; i < e; ++i) {
+        const std::int64_t x = px_[i], y = py_[i];
+        bool hit = false;
+        for (int k = 0; k < GHOSTS; ++k) {
+            std::int64_t dx = gx[i*GHOSTS + k] - x, dy = gy[i*GHOSTS + k] - y;
+            hit |= dx*dx + dy*dy < HIT_DIST2;
+        }
+        if (hit) {
+            if (--lives_[i] <= 0) done_[i] = 1;
+            resetPositions(i);
+        }
+        if (pelletsLeft_[i] == 0) done_[i] = 1;
+        episodes_[i] += done_[i];
+    }
+}
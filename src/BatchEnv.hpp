@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Level.hpp"
+#include "Random.hpp"
+#include "Simulation.hpp"
+#include "WorkerPool.hpp"
+
+// N independent games advanced together. The maze geometry is shared; every
+// per-game quantity lives in structure-of-arrays buffers so movement, wrap and
+// collision run as flat loops over contiguous fixed-point integers. Envs are processed in
+// chunks spread over a work-stealing WorkerPool.
+class BatchEnv {
+public:
+    static constexpr int GHOSTS = Simulation::GHOSTS;
+    static constexpr int CHUNK  = 64;                 // envs per scheduling unit
+
+    BatchEnv(const std::string& levelFile, int envs, std::uint64_t seed, unsigned threads = 0);
+
+    // one action per env; envs that finished on the previous step restart first
+    void step(const Dir* actions);
+
+    int      size()    const { return envs_; }
+    unsigned threads() const { return pool_.size(); }
+
+    std::uint64_t episodes() const;                   // completed games so far
+    unsigned score(int e)    const { return score_[e]; }
+    int      lives(int e)    const { return lives_[e]; }
+    bool     done(int e)     const { return done_[e] != 0; }
+
+    // positions in SUBPX units
+    const std::int32_t* playerX() const { return px_.data(); }
+    const std::int32_t* playerY() const { return py_.data(); }
+    const std::int32_t* ghostX()  const { return gx_.data(); }   // env e owns [e*GHOSTS, (e+1)*GHOSTS)
+    const std::int32_t* ghostY()  const { return gy_.data(); }
+
+private:
+    void stepRange(std::size_t b, std::size_t e, const Dir* actions);
+    void resetEnv(std::size_t e);
+    void resetPositions(std::size_t e);
+
+    Level       level_;
+    int         envs_;
+    std::int32_t mazeW_;
+    WorkerPool  pool_;
+
+    std::size_t                words_;         // Level bitboard words per env
+
+    // player, one entry per env
+    std::vector<std::int32_t> px_, py_;
+    std::vector<Dir>          pdir_, pnext_;
+    std::vector<Dir>          pface_;          // last non-None pdir_, as Player::facing
+    std::vector<std::uint8_t> ptp_;
+
+    // ghosts, GHOSTS entries per env
+    std::vector<std::int32_t> gx_, gy_;
+    std::vector<Dir>          gdir_;
+    std::vector<std::uint8_t> gtp_;
+
+    // per-env game state
+    std::vector<std::uint64_t> pellets_;       // words_ per env, Level::bit layout
+    std::vector<unsigned>      pelletsLeft_;
+    std::vector<unsigned>      score_;
+    std::vector<int>           lives_;
+    std::vector<std::uint8_t>  done_;
+    std::vector<std::uint32_t> episodes_;
+    std::vector<std::uint64_t> rng_;           // SplitMix64 state
+};
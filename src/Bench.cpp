@@ -0,0 +1,416 @@
+#include "Simulation.hpp"
+#include "Movement.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef PACMAN_BENCH_SFML
+#include "FrameCapture.hpp"
+#include "LevelView.hpp"
+#include "SfmlCompat.hpp"
+#endif
+
+// microbenchmarks for the hot paths plus whole simulation ticks.
+// Each benchmark is a function running `ops` operations; the harness grows
+// ops until one repetition takes --min-time, then reports the median of
+// --reps repetitions in ns per op.
+// usage: pacman_bench [--filter SUBSTR] [--json FILE] [--level NAME|FILE] [--min-time SEC] [--reps N]
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// keeps a value alive so the optimiser cannot drop the work producing it
+template<class T>
+inline void keep(const T& v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(v) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &v;
+#endif
+}
+
+struct Bench {
+    std::string name;
+    std::function<void(std::uint64_t ops)> run;
+};
+
+struct Result {
+    std::string   name;
+    double        nsPerOp;
+    double        minNs, maxNs;
+    std::uint64_t ops;
+};
+
+Result measure(const Bench& b, double minTime, int reps)
+{
+    auto once = [&](std::uint64_t ops) {
+        auto t0 = Clock::now();
+        b.run(ops);
+        return std::chrono::duration<double>(Clock::now() - t0).count();
+    };
+
+    once(1);                    // warm-up: lazily built inputs, caches
+    std::uint64_t ops = 1;
+    for (double t = once(ops); t < minTime && ops < (1ull << 40); t = once(ops))
+        ops = t > 0 ? std::max(ops * 2, std::uint64_t(ops * minTime * 1.2 / t)) : ops * 16;
+
+    std::vector<double> ns;
+    for (int r = 0; r < reps; ++r) ns.push_back(once(ops) * 1e9 / double(ops));
+    std::sort(ns.begin(), ns.end());
+    return {b.name, ns[ns.size() / 2], ns.front(), ns.back(), ops};
+}
+
+// a w x h grid of pillars; 101x81 already has more walkable tiles than
+// Level::MAX_TABLE_NODES, so ghosts ask the cluster hierarchy instead
+Level gridMaze(int w, int h)
+{
+    // (x, y) with both odd is always floor
+    std::string text = "; player 1 1\n; ghost " + std::to_string(w / 2 | 1) + " " + std::to_string(h / 2 | 1) + "\n";
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            bool wall = x == 0 || y == 0 || x == w - 1 || y == h - 1 || (x % 2 == 0 && y % 2 == 0);
+            text += wall ? '#' : '.';
+        }
+        text += '\n';
+    }
+    return Level::fromText(text, "grid" + std::to_string(w) + "x" + std::to_string(h));
+}
+
+// every tile centre of the level where a body fits, in row order
+std::vector<Fixed2> openCenters(const Level& lvl)
+{
+    std::vector<Fixed2> v;
+    for (int y = 0; y < lvl.height(); ++y)
+        for (int x = 0; x < lvl.width(); ++x)
+            if (canOccupy(lvl, tileCenter({x, y}))) v.push_back(tileCenter({x, y}));
+    return v;
+}
+
+// positions where a ghost has to choose, with a heading it could arrive on
+struct Decision { Fixed2 pos; Dir cur; };
+std::vector<Decision> decisionPoints(const Level& lvl)
+{
+    std::vector<Decision> v;
+    for (Fixed2 p : openCenters(lvl))
+        for (Dir d : {Dir::Left, Dir::Right, Dir::Up, Dir::Down})
+            if (Ghost::needsDecision(lvl, p, d)) { v.push_back({p, d}); break; }
+    return v;
+}
+
+// random bot input, a new direction every half second
+struct Bot {
+    SplitMix64 rng;
+    Dir        dir{Dir::Left};
+
+    Dir next(std::uint64_t tick)
+    {
+        if (tick % (Simulation::TICK_HZ / 2) == 0) dir = Dir(1 + randomBelow(rng, 4));
+        return dir;
+    }
+};
+
+// whole ticks of a session with the given ghost count and collision method
+void simTicks(const Level& lvl, int ghosts, CollisionMode mode, std::uint64_t ops)
+{
+    Simulation sim(lvl, 1, ghosts);
+    sim.setCollisionMode(mode);
+    Bot   bot{{2}};
+    Input in;
+    for (std::uint64_t i = 0; i < ops; ++i) {
+        in.dir     = bot.next(i);
+        in.restart = sim.finished();
+        keep(sim.step(in));
+    }
+}
+
+// TICKS consecutive ticks of ghost and player positions from a real
+// session, so the collision benchmarks see realistic motion
+struct Trajectory {
+    static constexpr int TICKS = 64;
+    int ghosts;
+    std::vector<Fixed2> ghost;         // TICKS x ghosts
+    std::vector<Fixed2> player;        // TICKS
+
+    Trajectory(const Level& lvl, int n) : ghosts(n)
+    {
+        Simulation sim(lvl, 1, n);
+        Bot   bot{{2}};
+        Input in;
+        for (int t = 0; t < TICKS; ++t) {
+            in.dir = bot.next(std::uint64_t(t));
+            sim.step(in);
+            for (auto& g : sim.ghosts()) ghost.push_back(g.position());
+            player.push_back(sim.player().position());
+        }
+    }
+    const Fixed2* at(std::uint64_t tick) const { return &ghost[tick % TICKS * ghosts]; }
+};
+
+#ifdef PACMAN_BENCH_SFML
+const sf::Texture& tileset()
+{
+    static sf::Texture tiles;
+    static bool loaded = tiles.loadFromFile("resources/textures/tiles.png");
+    keep(loaded);
+    return tiles;
+}
+
+// ops frames of a classic-board view moving 2 px per frame along a
+// diagonal of the maze
+void scrollFrames(const Level& maze, std::uint64_t ops)
+{
+    const sf::Vector2f size{28.f * TILE, 31.f * TILE};
+    const float spanX = maze.width() * TILE - size.x, spanY = maze.height() * TILE - size.y;
+    sf::RenderTexture rt;
+    RENDER_TEXTURE_CREATE(rt, unsigned(size.x), unsigned(size.y));
+    LevelView view(maze, tileset());
+    PelletBoard pellets;
+    pellets.follow(maze);
+    sf::View camera(size / 2.f, size);
+    for (std::uint64_t i = 0; i < ops; ++i) {
+        const float d = float(i * 2 % std::uint64_t(std::min(spanX, spanY)));
+        camera.setCenter({size.x / 2.f + d, size.y / 2.f + d});
+        rt.setView(camera);
+        rt.clear();
+        view.draw(rt, pellets);
+        rt.display();
+    }
+}
+#endif
+
+std::vector<Bench> benches(const std::string& levelFile)
+{
+    static const Level lvl = Level::open(levelFile);
+    static const Level big = gridMaze(101, 81);
+    static const std::vector<Fixed2>   centers = openCenters(lvl);
+    static const std::vector<Decision> points  = decisionPoints(lvl);
+    static const std::vector<Decision> bigPts  = decisionPoints(big);
+
+    std::vector<Bench> v;
+
+    v.push_back({"level/isWalkable", [](std::uint64_t ops) {
+        const int w = lvl.width(), h = lvl.height();
+        unsigned n = 0;
+        for (std::uint64_t i = 0; i < ops; ++i)
+            n += lvl.isWalkable(int(i % w), int(i / w % h));
+        keep(n);
+    }});
+
+    v.push_back({"level/pelletsRemaining", [](std::uint64_t ops) {
+        unsigned n = 0;
+        for (std::uint64_t i = 0; i < ops; ++i) { n += lvl.pelletsRemaining(); keep(n); }
+    }});
+
+    v.push_back({"movement/canMove", [](std::uint64_t ops) {
+        unsigned n = 0;
+        const Dir dirs[4]{Dir::Left, Dir::Right, Dir::Up, Dir::Down};
+        for (std::uint64_t i = 0; i < ops; ++i)
+            n += canMove(lvl, centers[i % centers.size()], dirs[i & 3]);
+        keep(n);
+    }});
+
+    v.push_back({"ghost/decide_table", [](std::uint64_t ops) {
+        SplitMix64 rng{7};
+        const Fixed2 target = tileCenter(lvl.playerStart());
+        for (std::uint64_t i = 0; i < ops; ++i) {
+            const Decision& d = points[i % points.size()];
+            keep(Ghost::decide(lvl, d.pos, d.cur, target, rng));
+        }
+    }});
+
+    // what a ghost pays per tile centre: the corridor lookup, and decide()
+    // only at junctions
+    v.push_back({"ghost/tile_centre", [](std::uint64_t ops) {
+        SplitMix64 rng{7};
+        const Fixed2 target = tileCenter(lvl.playerStart());
+        for (std::uint64_t i = 0; i < ops; ++i) {
+            const Decision& d = points[i % points.size()];
+            Dir nd = Ghost::corridorHeading(lvl, d.pos, d.cur);
+            if (nd == Dir::None) nd = Ghost::decide(lvl, d.pos, d.cur, target, rng);
+            keep(nd);
+        }
+    }});
+
+    v.push_back({"ghost/decide_clusters", [](std::uint64_t ops) {
+        SplitMix64 rng{7};
+        const Fixed2 target = tileCenter({big.width() / 2, big.height() / 2 + 1});
+        for (std::uint64_t i = 0; i < ops; ++i) {
+            const Decision& d = bigPts[i % bigPts.size()];
+            keep(Ghost::decide(big, d.pos, d.cur, target, rng));
+        }
+    }});
+
+    // the same on a 2048x2048 lattice, from random junctions to its middle:
+    // what one decision costs when the player is up to two thousand tiles off
+    v.push_back({"ghost/decide_clusters_2048", [](std::uint64_t ops) {
+        static const Level huge = gridMaze(2049, 2049);
+        SplitMix64 rng{7};
+        const Fixed2 target = tileCenter({huge.width() / 2 | 1, huge.height() / 2 | 1});
+        const Dir dirs[4]{Dir::Left, Dir::Right, Dir::Up, Dir::Down};
+        for (std::uint64_t i = 0; i < ops; ++i) {
+            const Vec2i at{int(randomBelow(rng, 1024)) * 2 + 1, int(randomBelow(rng, 1024)) * 2 + 1};
+            keep(Ghost::decide(huge, tileCenter(at), dirs[i & 3], target, rng));
+        }
+    }});
+
+    // rebuilding after a tile changes: one cluster, or three on a border
+    v.push_back({"paths/invalidate", [](std::uint64_t ops) {
+        static PathHierarchy paths = big.paths();
+        for (std::uint64_t i = 0; i < ops; ++i)
+            paths.invalidate(big, {int(i * 7 % std::uint64_t(big.width())), int(i * 13 % std::uint64_t(big.height()))});
+        keep(paths.entrances());
+    }});
+
+    // brute force against the spatial hash, per tick: collision alone and
+    // the whole step
+    for (int n : {4, 64, 1024, 8192}) {
+        const std::string g = std::to_string(n);
+        auto traj = std::make_shared<Trajectory>(lvl, n);
+
+        v.push_back({"collision/brute_" + g, [traj](std::uint64_t ops) {
+            unsigned hits = 0;
+            for (std::uint64_t i = 0; i < ops; ++i) {
+                const Fixed2* gs = traj->at(i);
+                const Fixed2  p  = traj->player[i % Trajectory::TICKS];
+                for (int k = 0; k < traj->ghosts; ++k)
+                    if (touching(gs[k], p)) { ++hits; break; }
+            }
+            keep(hits);
+        }});
+        v.push_back({"collision/hash_" + g, [traj](std::uint64_t ops) {
+            SpatialHash hash;
+            hash.build(std::size_t(traj->ghosts), [&](std::size_t k){ return traj->at(0)[k]; });
+            unsigned hits = 0;
+            for (std::uint64_t i = 0; i < ops; ++i) {
+                const Fixed2* gs = traj->at(i);
+                const Fixed2  p  = traj->player[i % Trajectory::TICKS];
+                for (int k = 0; k < traj->ghosts; ++k) hash.move(std::uint32_t(k), gs[k]);
+                hits += hash.anyNear(p, [&](std::uint32_t k){ return touching(gs[k], p); });
+            }
+            keep(hits);
+        }});
+
+        v.push_back({"sim/tick_" + g + "_ghosts_brute",
+                     [n](std::uint64_t ops) { simTicks(lvl, n, CollisionMode::BruteForce, ops); }});
+        v.push_back({"sim/tick_" + g + "_ghosts_hash",
+                     [n](std::uint64_t ops) { simTicks(lvl, n, CollisionMode::SpatialHash, ops); }});
+    }
+
+#ifdef PACMAN_BENCH_SFML
+    v.push_back({"render/levelview_draw", [](std::uint64_t ops) {
+        sf::RenderTexture rt;
+        RENDER_TEXTURE_CREATE(rt, unsigned(lvl.width() * TILE), unsigned(lvl.height() * TILE));
+        LevelView view(lvl, tileset());
+        PelletBoard pellets;
+        pellets.follow(lvl);
+        for (std::uint64_t i = 0; i < ops; ++i) {
+            rt.clear();
+            view.draw(rt, pellets);
+            rt.display();
+        }
+    }});
+
+    // level1 drawn offscreen, read back and encoded; per frame, so
+    // 1/ns_per_op is the capture frame rate
+    v.push_back({"render/capture_y4m", [](std::uint64_t ops) {
+        const std::string out = (std::filesystem::temp_directory_path() / "pacman_bench.y4m").string();
+        FrameCapture capture(out, {unsigned(lvl.width() * TILE), unsigned(lvl.height() * TILE)},
+                             Simulation::TICK_HZ);
+        LevelView view(lvl, tileset());
+        PelletBoard pellets;
+        pellets.follow(lvl);
+        for (std::uint64_t i = 0; i < ops; ++i) {
+            capture.target().clear();
+            view.draw(capture.target(), pellets);
+            capture.submit();
+        }
+        capture.finish();
+        std::filesystem::remove(out);
+    }});
+
+    // a classic-board window scrolling over ever bigger mazes; frame time
+    // should not depend on the maze size
+    for (int n : {1024, 4096}) {
+        v.push_back({"render/levelview_scroll_" + std::to_string(n), [n](std::uint64_t ops) {
+            static std::unique_ptr<Level> maze;
+            if (!maze || maze->width() != n) maze = std::make_unique<Level>(gridMaze(n, n));
+            scrollFrames(*maze, ops);
+        }});
+    }
+#endif
+    return v;
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results, double minTime, int reps)
+{
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << "{\n  \"context\": {\"date\": \"" << date << "\", \"min_time\": " << minTime
+        << ", \"repetitions\": " << reps << "},\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"ns_per_op\": " << r.nsPerOp
+            << ", \"min_ns\": " << r.minNs << ", \"max_ns\": " << r.maxNs
+            << ", \"ops\": " << r.ops << '}' << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n}\n";
+}
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter, json;
+    std::string level   = "level1";
+    double      minTime = 0.2;
+    int         reps    = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc)
+            json = argv[++i];
+        else if (!std::strcmp(argv[i], "--level") && i + 1 < argc)
+            level = argv[++i];
+        else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc)
+            minTime = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--reps") && i + 1 < argc)
+            reps = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--filter SUBSTR] [--json FILE] [--level NAME|FILE] [--min-time SEC] [--reps N]\n";
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    for (const Bench& b : benches(level)) {
+        if (b.name.find(filter) == std::string::npos) continue;
+        Result r = measure(b, minTime, reps);
+        std::cout << std::left << std::setw(26) << r.name << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(14) << r.nsPerOp << " ns/op"
+                  << std::setw(14) << r.ops << " ops\n";
+        results.push_back(r);
+    }
+
+    if (!json.empty()) {
+        std::ofstream out(json);
+        if (!out) {
+            std::cerr << "ERROR: cannot write " << json << '\n';
+            return 1;
+        }
+        writeJson(out, results, minTime, reps);
+    }
+    return 0;
+}
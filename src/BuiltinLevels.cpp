@@ -0,0 +1,43 @@
+#include "Level.hpp"
+#include "LevelFormat.hpp"
+#include "BuiltinLevelText.hpp"
+#include <stdexcept>
+
+// every level in resources/levels, parsed by the compiler; a malformed one
+// stops the build here
+namespace {
+#define PACMAN_BAKE_LEVEL(name)                                                      \
+    constexpr levelfmt::Dims name##_dims = levelfmt::dims(builtin_level_text::name);  \
+    constexpr auto name##_baked = levelfmt::bake<name##_dims.width, name##_dims.height>( \
+        builtin_level_text::name, #name);
+PACMAN_BUILTIN_LEVELS(PACMAN_BAKE_LEVEL)
+#undef PACMAN_BAKE_LEVEL
+
+#define PACMAN_LEVEL_TABLES(name) name##_baked.tables(),
+constexpr levelfmt::LevelTables BUILTIN[] = {PACMAN_BUILTIN_LEVELS(PACMAN_LEVEL_TABLES)};
+#undef PACMAN_LEVEL_TABLES
+
+const levelfmt::LevelTables* find(std::string_view name)
+{
+    for (const auto& t : BUILTIN)
+        if (t.name == name) return &t;
+    return nullptr;
+}
+}
+
+Level Level::builtin(std::string_view name)
+{
+    const levelfmt::LevelTables* t = find(name);
+    if (!t) throw std::runtime_error("no built-in level " + std::string(name));
+    return Level(*t);
+}
+
+bool Level::isBuiltin(std::string_view name)
+{
+    return find(name) != nullptr;
+}
+
+Level Level::open(const std::string& nameOrFile)
+{
+    return isBuiltin(nameOrFile) ? builtin(nameOrFile) : Level(nameOrFile);
+}
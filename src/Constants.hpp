@@ -4,6 +4,11 @@ inline constexpr float SPEED_PX    = 2.f;
 inline constexpr float PAC_RADIUS  = TILE * 0.48f;
 inline constexpr float COLL_RADIUS = PAC_RADIUS * 0.80f;
 
+// fixed-point simulation units per pixel; a tile is TILE_FX units
+inline constexpr int SUBPX    = 16;
+inline constexpr int TILE_FX  = TILE * SUBPX;
+inline constexpr int SPEED_FX = int(SPEED_PX * SUBPX);
+
 inline constexpr float PI          = 3.14159f;
 
 
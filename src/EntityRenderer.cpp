@@ -0,0 +1,80 @@
+#include "EntityRenderer.hpp"
+#include <cmath>
+
+namespace {
+int facingIndex(Dir d)
+{
+    switch (d) {
+        case Dir::Up:   return 1;
+        case Dir::Down: return 2;
+        case Dir::Left: return 3;
+        default:        return 0;    // right
+    }
+}
+}
+
+// fan of SEGS triangles around the origin covering [from, from+span] radians
+void EntityRenderer::bakeFan(Shape& out, float from, float span)
+{
+    const float r = PAC_RADIUS;
+    for (int i = 0; i < SEGS; ++i) {
+        float a0 = from + span * i / SEGS, a1 = from + span * (i + 1) / SEGS;
+        out[i*3+0] = {0.f, 0.f};
+        out[i*3+1] = {std::cos(a0) * r, std::sin(a0) * r};
+        out[i*3+2] = {std::cos(a1) * r, std::sin(a1) * r};
+    }
+}
+
+EntityRenderer::EntityRenderer()
+: batch_(sf::PrimitiveType::Triangles)
+{
+    bakeFan(disc_, 0.f, 2.f * PI);
+
+    const float facingDeg[4] = {0.f, -90.f, 90.f, 180.f};
+    for (int f = 0; f < 4; ++f)
+        for (int m = 0; m < MOUTH_FRAMES; ++m) {
+            float deg = 40.f * m / (MOUTH_FRAMES - 1);
+            if (deg < 2.f) deg = 0.f;                 // closed below 2 degrees
+            float from = (facingDeg[f] + deg) * PI / 180.f;
+            float span = (360.f - 2.f * deg) * PI / 180.f;
+            bakeFan(pies_[f * MOUTH_FRAMES + m], from, span);
+        }
+}
+
+void EntityRenderer::emit(const Shape& s, sf::Vector2f at, sf::Color c)
+{
+    sf::Vertex v;
+    v.color = c;
+    for (const auto& o : s) {
+        v.position = {at.x + o.x, at.y + o.y};
+        batch_.append(v);
+    }
+}
+
+void EntityRenderer::addGhost(Vec2 pos, std::uint32_t rgba, sf::Vector2f offset)
+{
+    emit(disc_, {offset.x + pos.x, offset.y + pos.y}, sf::Color(rgba));
+}
+
+void EntityRenderer::addPlayer(Vec2 pos, Dir facing, float mouthPhase, sf::Vector2f offset)
+{
+    float open = std::abs(std::sin(mouthPhase));
+    int   m    = int(open * (MOUTH_FRAMES - 1) + 0.5f);
+    emit(pies_[facingIndex(facing) * MOUTH_FRAMES + m],
+         {offset.x + pos.x, offset.y + pos.y}, sf::Color::Yellow);
+}
+
+void EntityRenderer::add(const Simulation& sim, sf::Vector2f offset)
+{
+    for (auto& g : sim.ghosts())
+        addGhost(toPixels(g.position()), g.color(), offset);
+    const Player& p = sim.player();
+    addPlayer(toPixels(p.position()), p.facing(), p.mouthPhase(), offset);
+}
+
+void EntityRenderer::add(const SimSnapshot& s, float alpha, sf::Vector2f offset)
+{
+    for (auto& g : s.ghosts)
+        addGhost(g.at(alpha), g.color, offset);
+    addPlayer(s.player.at(alpha), s.facing, s.mouthPhase, offset);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstdint>
+#include "Geometry.hpp"
+#include "SimSnapshot.hpp"
+#include "Simulation.hpp"
+
+// collects Pac-Man and ghosts into one triangle batch drawn with a single
+// call. Shapes are baked once as vertex offsets: a disc for ghosts and, for
+// Pac-Man, a pie per facing direction and quantised mouth opening. An offset
+// per add() lets a spectator wall batch many games together.
+class EntityRenderer {
+public:
+    EntityRenderer();
+
+    void clear() { batch_.clear(); }
+    void add(const Simulation& sim, sf::Vector2f offset = {});
+    void add(const SimSnapshot& s, float alpha, sf::Vector2f offset = {});   // see SimSnapshot::Body::at
+    void addGhost(Vec2 pos, std::uint32_t rgba, sf::Vector2f offset = {});
+    void addPlayer(Vec2 pos, Dir facing, float mouthPhase, sf::Vector2f offset = {});
+    void draw(sf::RenderTarget& rt) const { rt.draw(batch_); }
+
+private:
+    static constexpr int SEGS         = 24;          // triangles per shape
+    static constexpr int VERTS        = SEGS * 3;
+    static constexpr int MOUTH_FRAMES = 16;          // openings from 0 to 40 degrees
+
+    using Shape = std::array<sf::Vector2f, VERTS>;
+
+    static void bakeFan(Shape& out, float from, float span);
+    void emit(const Shape& s, sf::Vector2f at, sf::Color c);
+
+    Shape                                 disc_;
+    std::array<Shape, 4 * MOUTH_FRAMES>   pies_;     // [facing][frame]
+    sf::VertexArray                       batch_;
+};
@@ -0,0 +1,156 @@
+#include "FrameCapture.hpp"
+#include "SfmlCompat.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+FrameCapture::FrameCapture(const std::string& path, sf::Vector2u size, int fps, unsigned threads)
+: format_(std::filesystem::path(path).extension() == ".y4m" ? Format::Y4m : Format::Png)
+, path_(path)
+, size_(size)
+{
+    if (format_ == Format::Y4m) {
+        stream_.open(path, std::ios::binary);
+        if (!stream_) throw std::runtime_error("cannot write " + path);
+        char header[80];
+        const int n = std::snprintf(header, sizeof header, "YUV4MPEG2 W%u H%u F%d:1 Ip A1:1 C444\n",
+                                    size.x, size.y, fps);
+        stream_.write(header, n);
+    } else {
+        std::error_code ec;
+        std::filesystem::create_directories(path, ec);
+        if (!std::filesystem::is_directory(path, ec)) throw std::runtime_error("cannot create directory " + path);
+    }
+    for (sf::RenderTexture& rt : rt_)
+        if (!RENDER_TEXTURE_CREATE(rt, size.x, size.y))
+            throw std::runtime_error("cannot create a render texture");
+
+    // the renderer keeps a core to itself
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency() - 1);
+    pool_.resize(threads * 2 + 2);
+    for (Frame& f : pool_) {
+        f.rgba.resize(std::size_t(size.x) * size.y * 4);
+        if (format_ == Format::Y4m) f.planes.resize(std::size_t(size.x) * size.y * 3);
+        free_.push_back(&f);
+    }
+    for (unsigned i = 0; i < threads; ++i) threads_.emplace_back([this]{ workerLoop(); });
+}
+
+FrameCapture::~FrameCapture()
+{
+    try { finish(); } catch (const std::exception&) {}
+}
+
+void FrameCapture::submit()
+{
+    rt_[cur_].display();
+    if (pending_) readBack(cur_ ^ 1);
+    pending_ = true;
+    cur_ ^= 1;
+    ++submitted_;
+}
+
+void FrameCapture::readBack(int which)
+{
+    Frame* f;
+    {
+        std::unique_lock lk(m_);
+        if (free_.empty()) {
+            ++stalls_;
+            freed_.wait(lk, [this]{ return !free_.empty(); });
+        }
+        f = free_.back();
+        free_.pop_back();
+    }
+    // SFML has no asynchronous readback; by now the GPU is a frame ahead of it
+    const sf::Image img = rt_[which].getTexture().copyToImage();
+    std::memcpy(f->rgba.data(), img.getPixelsPtr(), f->rgba.size());
+    {
+        std::lock_guard lk(m_);
+        f->index = submitted_ - 1;
+        queue_.push_back(f);
+    }
+    work_.notify_one();
+}
+
+void FrameCapture::finish()
+{
+    if (threads_.empty()) return;
+    if (pending_) readBack(cur_ ^ 1);
+    pending_ = false;
+    {
+        std::lock_guard lk(m_);
+        stop_ = true;
+    }
+    work_.notify_all();
+    for (auto& t : threads_) t.join();
+    threads_.clear();
+    if (stream_.is_open()) stream_.close();
+    if (failed_) throw std::runtime_error("cannot write " + path_);
+}
+
+// pops frames until stopped with the queue empty
+void FrameCapture::workerLoop()
+{
+    for (;;) {
+        Frame* f;
+        {
+            std::unique_lock lk(m_);
+            work_.wait(lk, [this]{ return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            f = queue_.front();
+            queue_.pop_front();
+        }
+        encode(*f);
+        {
+            std::lock_guard lk(m_);
+            free_.push_back(f);
+        }
+        freed_.notify_one();
+    }
+}
+
+void FrameCapture::encode(Frame& f)
+{
+    if (format_ == Format::Png) {
+        sf::Image img;
+        IMAGE_CREATE(img, size_.x, size_.y, f.rgba.data());
+        char name[32];
+        std::snprintf(name, sizeof name, "frame_%06llu.png", static_cast<unsigned long long>(f.index));
+        if (!img.saveToFile((std::filesystem::path(path_) / name).string())) failed_ = true;
+        return;
+    }
+
+    toYuv444(f.rgba.data(), f.planes.data());
+    // frames are queued in order, so the one being waited for is already
+    // with another worker
+    {
+        std::unique_lock lk(m_);
+        written_.wait(lk, [&]{ return nextWrite_ == f.index; });
+    }
+    stream_.write("FRAME\n", 6);
+    stream_.write(reinterpret_cast<const char*>(f.planes.data()), std::streamsize(f.planes.size()));
+    if (!stream_) failed_ = true;
+    {
+        std::lock_guard lk(m_);
+        ++nextWrite_;
+    }
+    written_.notify_all();
+}
+
+// BT.601, studio range, as y4m readers assume
+void FrameCapture::toYuv444(const std::uint8_t* rgba, std::uint8_t* planes) const
+{
+    const std::size_t n = std::size_t(size_.x) * size_.y;
+    std::uint8_t* y = planes;
+    std::uint8_t* u = planes + n;
+    std::uint8_t* v = planes + 2 * n;
+    for (std::size_t i = 0; i < n; ++i, rgba += 4) {
+        const int r = rgba[0], g = rgba[1], b = rgba[2];
+        y[i] = std::uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        u[i] = std::uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v[i] = std::uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
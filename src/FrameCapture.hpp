@@ -0,0 +1,74 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// turns frames drawn offscreen into files without holding up the renderer.
+// Frames are drawn into two RenderTextures in turn and each is read back
+// only after the next one has been drawn into the other, so the GPU has
+// finished it by the time the copy asks for it. The RGBA pixels go to a
+// few worker threads that encode them: a directory of numbered PNGs, or a
+// .y4m stream (YUV 4:4:4, which ffmpeg and most players read directly)
+// written in frame order.
+//
+// Pixel buffers come from a fixed pool; submit() only waits when every
+// one of them is still queued for the encoders (counted in stalls()).
+class FrameCapture {
+public:
+    enum class Format { Png, Y4m };
+
+    // path ending in .y4m: one stream, else a directory of PNGs. Throws
+    // if the output cannot be created or the textures cannot be made.
+    FrameCapture(const std::string& path, sf::Vector2u size, int fps, unsigned threads = 0);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    sf::RenderTarget& target() { return rt_[cur_]; }   // draw the next frame here
+    void submit();                                      // that frame is drawn
+    void finish();                                      // flushes everything; throws if a write failed
+
+    Format        format()  const { return format_; }
+    std::uint64_t frames()  const { return submitted_; }
+    std::uint64_t stalls()  const { return stalls_; }
+
+private:
+    struct Frame {
+        std::uint64_t             index{0};
+        std::vector<std::uint8_t> rgba;
+        std::vector<std::uint8_t> planes;    // Y, U, V for .y4m
+    };
+
+    void readBack(int which);
+    void workerLoop();
+    void encode(Frame& f);
+    void toYuv444(const std::uint8_t* rgba, std::uint8_t* planes) const;
+
+    Format                     format_;
+    std::string                path_;
+    sf::Vector2u               size_;
+    std::array<sf::RenderTexture, 2> rt_;
+    int                        cur_{0};
+    bool                       pending_{false};   // rt_[cur_ ^ 1] holds a frame not yet read back
+    std::uint64_t              submitted_{0}, stalls_{0};
+
+    std::vector<Frame>         pool_;
+    std::vector<Frame*>        free_;
+    std::deque<Frame*>         queue_;
+    std::mutex                 m_;
+    std::condition_variable    work_, freed_, written_;
+    std::uint64_t              nextWrite_{0};     // .y4m frames go out in order
+    std::ofstream              stream_;
+    std::atomic<bool>          failed_{false};
+    bool                       stop_{false};
+    std::vector<std::thread>   threads_;
+};
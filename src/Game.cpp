@@ -1,247 +1,454 @@
 #include "Game.hpp"
+#include "AllocCounter.hpp"
 #include "Constants.hpp"
-#include <cmath>
+#include "FrameCapture.hpp"
+#include "SfmlCompat.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <random>
+#include <stdexcept>
 
-#if SFML_VERSION_MAJOR >= 3
-#   define TEXT_CTOR(font, str) font, str
-#   define FONT_OPEN(font, file) font.openFromFile(file)
-#   define SOUND_SET_LOOP(sound, v) sound.setLooping(v)
-#   define RECT_W(r) r.size.x
-#   define RECT_H(r) r.size.y
-#else
-#   define TEXT_CTOR(font, str) str, font
-#   define FONT_OPEN(font, file) font.loadFromFile(file)
-#   define SOUND_SET_LOOP(sound, v) sound.setLoop(v)
-#   define RECT_W(r) r.width
-#   define RECT_H(r) r.height
+// ctor
+Game::Game(AssetManager& assets, const GameOptions& opts)
+: assets_(assets)
+, opts_(opts)
+, sim_(openSession())
+, levelView_(sim_.level(), assets.texture(TextureId::Tiles))
+, camera_(sf::Vector2f(viewSize()) / 2.f, sf::Vector2f(viewSize()))
+, hudFont_(assets.font(FontId::Hud))
+, clearText_(TEXT_CTOR(hudFont_, ""))
+, gameOverText_(TEXT_CTOR(hudFont_, ""))
+, scoreText_(TEXT_CTOR(hudFont_, ""))
+, livesText_(TEXT_CTOR(hudFont_, ""))
+, mixer_(assets)
+#ifdef PACMAN_PROFILE
+, profileText_(TEXT_CTOR(hudFont_, ""))
 #endif
-
-// texture singleton
-static const sf::Texture& tiles()
 {
-    static sf::Texture* tex = nullptr;
-    if (!tex)
-    {
-        tex = new sf::Texture;
-        if (!tex->loadFromFile("resources/textures/tiles.png"))
-            std::cerr << "ERROR: cannot load resources/textures/tiles.png\n";
+    // the simulation keeps its own time, so frames go at the display's rate
+    if (!capturing()) {
+        window_.create(sf::VideoMode(viewSize()), "Pac-Man 3", sf::Style::Default);
+        window_.setVerticalSyncEnabled(true);
+    }
+
+    if (!opts_.record.empty() && !recorder_.open(opts_.record, inputlog::Session::of(sim_, opts_.level)))
+        std::cerr << "ERROR: cannot write input log " << opts_.record << '\n';
+
+    if (!capturing()) {
+        mixer_.playSound(SoundId::Start);
+        mixer_.playSound(SoundId::Siren, SIREN_VOLUME, true);
+        mixer_.play();
     }
-    return *tex;
+
+#ifdef PACMAN_PROFILE
+    Profiler::get().setEnabled(true);
+    if (!opts_.trace.empty() && !Profiler::get().openTrace(opts_.trace))
+        std::cerr << "ERROR: cannot write trace " << opts_.trace << '\n';
+    profileText_.setCharacterSize(8);
+    profileText_.setFillColor(sf::Color::Green);
+    profileText_.setPosition({4.f, 4.f});
+#endif
+
+    clearText_.setCharacterSize(14);
+    clearText_.setFillColor(sf::Color::Yellow);
+    clearText_.setString("LEVEL CLEAR!\nPress Space");
+    auto r = clearText_.getLocalBounds();
+    clearText_.setOrigin({RECT_W(r) / 2.f, RECT_H(r) / 2.f});
+    clearText_.setPosition({viewSize().x / 2.f, viewSize().y / 2.f});
+
+    gameOverText_.setFont(hudFont_);
+    gameOverText_.setCharacterSize(14);
+    gameOverText_.setFillColor(sf::Color::Yellow);
+    gameOverText_.setString("GAME OVER\nPress Space");
+    r = gameOverText_.getLocalBounds();
+    gameOverText_.setOrigin({RECT_W(r) / 2.f, RECT_H(r) / 2.f});
+    gameOverText_.setPosition({viewSize().x / 2.f, viewSize().y / 2.f});
+
+    for (sf::Text* t : {&scoreText_, &livesText_}) {
+        t->setCharacterSize(12);
+        t->setFillColor(sf::Color::White);
+    }
+    scoreText_.setPosition({4.f, float(viewSize().y - 14)});
+    livesText_.setPosition({float(viewSize().x - 96), float(viewSize().y - 14)});
 }
 
-// buffer singletons
-static sf::SoundBuffer& startBuf()
+// a replay is built from its log, level, ghosts and all, so the log is
+// opened here, before sim_ is constructed
+Simulation Game::openSession()
 {
-    static sf::SoundBuffer* buf = nullptr;
-    if (!buf) {
-        buf = new sf::SoundBuffer;
-        if (!buf->loadFromFile("resources/audio/start.wav"))
-            std::cerr << "ERROR: cannot load resources/audio/start.wav\n";
+    if (!opts_.replay.empty()) {
+        if (!replay_.open(opts_.replay))
+            throw std::runtime_error("cannot read input log " + opts_.replay);
+        const inputlog::Session& rec = replay_.session();
+        opts_.level  = rec.level;
+        opts_.ghosts = int(rec.ghosts);
+        Simulation sim(rec.level, rec.seed, int(rec.ghosts));
+        sim.setCollisionMode(rec.collision);
+        return sim;
+    }
+    std::uint64_t seed = 0;
+    if (opts_.seed) seed = *opts_.seed;
+    else {
+        std::random_device rd;
+        seed = (std::uint64_t(rd()) << 32) | rd();
     }
-    return *buf;
+    return Simulation(opts_.level, seed, opts_.ghosts);
 }
 
-static sf::SoundBuffer& sirenBuf()
+// window size in pixels: the maze, up to the classic board
+sf::Vector2u Game::viewSize() const
 {
-    static sf::SoundBuffer* buf = nullptr;
-    if (!buf) {
-        buf = new sf::SoundBuffer;
-        if (!buf->loadFromFile("resources/audio/siren.wav"))
-            std::cerr << "ERROR: cannot load resources/audio/siren.wav\n";
-    }
-    return *buf;
+    const Level& lvl = sim_.level();
+    return {unsigned(std::min(lvl.width(),  VIEW_TILES_X) * TILE),
+            unsigned(std::min(lvl.height(), VIEW_TILES_Y) * TILE)};
 }
 
-static sf::SoundBuffer& deathBuf()
+// centres the camera on the player, clamped so it never shows past the maze
+void Game::followPlayer(Vec2 p)
 {
-    static sf::SoundBuffer* buf = nullptr;
-    if (!buf) {
-        buf = new sf::SoundBuffer;
-        if (!buf->loadFromFile("resources/audio/death.wav"))
-            std::cerr << "ERROR: cannot load resources/audio/death.wav\n";
-    }
-    return *buf;
+    const Level& lvl = sim_.level();
+    const sf::Vector2f half = camera_.getSize() / 2.f;
+    const sf::Vector2f maze{float(lvl.width() * TILE), float(lvl.height() * TILE)};
+    camera_.setCenter({std::clamp(p.x, half.x, std::max(half.x, maze.x - half.x)),
+                       std::clamp(p.y, half.y, std::max(half.y, maze.y - half.y))});
 }
 
-static sf::SoundBuffer& gameOverBuf()
+// input, sampled every frame for the next tick
+void Game::readInput()
 {
-    static sf::SoundBuffer* buf = nullptr;
-    if (!buf) {
-        buf = new sf::SoundBuffer;
-        if (!buf->loadFromFile("resources/audio/gameover.wav"))
-            std::cerr << "ERROR: cannot load resources/audio/gameover.wav\n";
+    PROFILE_SCOPE(Phase::Input);
+    using K = sf::Keyboard::Key;
+    Dir dir = Dir::None;
+    if (sf::Keyboard::isKeyPressed(K::Left))  dir = Dir::Left;
+    if (sf::Keyboard::isKeyPressed(K::Right)) dir = Dir::Right;
+    if (sf::Keyboard::isKeyPressed(K::Up))    dir = Dir::Up;
+    if (sf::Keyboard::isKeyPressed(K::Down))  dir = Dir::Down;
+    heldDir_.store(dir, std::memory_order_relaxed);
+    rewindHeld_.store(sf::Keyboard::isKeyPressed(K::Backspace), std::memory_order_relaxed);
+}
+
+// sounds; a capture runs silent
+void Game::playSounds(unsigned ev)
+{
+    if (capturing()) return;
+    if (ev & EV_RESTART) {
+        mixer_.stopAllSounds();
+        mixer_.playSound(SoundId::Start);
+        mixer_.playSound(SoundId::Siren, SIREN_VOLUME, true);
+    }
+    if (ev & EV_PELLET) {
+        mixer_.playSound(munchId_ ? SoundId::Munch2 : SoundId::Munch1, MUNCH_VOLUME);
+        munchId_ ^= 1;
+    }
+    if (ev & EV_DEATH)  mixer_.playSound(SoundId::Death);
+    if (ev & EV_GAME_OVER) {
+        mixer_.stopSound(SoundId::Siren);
+        mixer_.playSound(SoundId::GameOver);
+    }
+    if (ev & EV_LEVEL_CLEAR) {
+        mixer_.stopSound(SoundId::Siren);
+        mixer_.playSound(SoundId::Win);
     }
-    return *buf;
 }
 
-static sf::SoundBuffer& winBuf()
+// one simulation step, logged when recording, rewound while Backspace is held
+void Game::tick(const Input& in)
 {
-    static sf::SoundBuffer* buf = nullptr;
-    if (!buf) {
-        buf = new sf::SoundBuffer;
-        if (!buf->loadFromFile("resources/audio/win.wav"))
-            std::cerr << "ERROR: cannot load resources/audio/win.wav\n";
+    if (rewinding()) {
+        if (rewind_->pop(snapshot_)) sim_.restore(snapshot_);
+        return;
+    }
+    recorder_.record(in);
+    playSounds(sim_.step(in));
+    if (rewindable()) {
+        sim_.save(snapshot_);
+        rewind_->push(snapshot_);
     }
-    return *buf;
 }
 
-// ctor
-Game::Game()
-: level_("resources/levels/level1.txt", tiles())
-, window_(sf::VideoMode({unsigned(level_.width()  * TILE),
-                         unsigned(level_.height() * TILE)}),
-          "Pac-Man 3", sf::Style::Default)
-, player_([this](unsigned p){ score_ += p; })
-, clearText_(TEXT_CTOR(hudFont_, ""))
-, gameOverText_(TEXT_CTOR(hudFont_, ""))
-    , startSnd_(startBuf())
-    , siren_   (sirenBuf())
-    , deathSnd_(deathBuf())
-    , gameOverSnd_(gameOverBuf())
-    , winSnd_(winBuf())
+// snapshots cover the classic four ghosts and boards up to GameState's size
+bool Game::rewindable() const
 {
-    window_.setFramerateLimit(60);
+    return !recorder_.isOpen() && sim_.ghosts().size() == Simulation::GHOSTS
+        && sim_.level().bitboardWords() <= GameState::MAX_PELLET_WORDS;
+}
 
-    FONT_OPEN(hudFont_, "resources/fonts/PressStart2P.ttf");
+bool Game::rewinding() const
+{
+    return rewindable() && rewindHeld_.load(std::memory_order_relaxed);
+}
 
-    startSnd_.play();
+// compares the replayed session with the recording's trailer
+void Game::reportReplay()
+{
+    std::clog << "replay finished at tick " << sim_.tick()
+              << ", score " << sim_.score() << '\n';
+    if (!replay_.hasTrailer())
+        std::clog << "replay: recording was not finished, nothing to verify\n";
+    else if (sim_.tick() == replay_.expectedTick() && sim_.score() == replay_.expectedScore()
+             && sim_.checksum() == replay_.expectedChecksum())
+        std::clog << "replay: identical to the recording\n";
+    else
+        std::clog << "replay: MISMATCH against the recording\n";
+}
 
-    SOUND_SET_LOOP(siren_, true);
-    siren_.setVolume(40.f);
-    siren_.play();
+#ifdef PACMAN_PROFILE
+// drains this frame's samples; rebuilds the overlay text now and then
+void Game::updateProfile()
+{
+    Profiler& prof = Profiler::get();
+    prof.collect();
+    if (!showProfile_ || ++profileFrame_ % PROFILE_REFRESH) return;
 
-    ghosts_.emplace_back(sf::Color::Red,
-                         sf::Vector2f(TILE*(13+0.5f), TILE*(14+0.5f)));
-    ghosts_.emplace_back(sf::Color::Cyan,
-                         sf::Vector2f(TILE*(14+0.5f), TILE*(14+0.5f)));
-    ghosts_.emplace_back(sf::Color::Magenta,
-                         sf::Vector2f(TILE*(12+0.5f), TILE*(14+0.5f)));
-    ghosts_.emplace_back(sf::Color(255,165,0),
-                         sf::Vector2f(TILE*(15+0.5f), TILE*(14+0.5f)));
+    std::string s = "phase          p50 us   p99 us\n";
+    char line[64];
+    for (int p = 0; p < PHASES; ++p) {
+        Profiler::Stats st = prof.stats(Phase(p));
+        std::snprintf(line, sizeof line, "%-12s %8.1f %8.1f\n", phaseName(Phase(p)), st.p50us, st.p99us);
+        s += line;
+    }
+    if (prof.dropped()) s += "dropped " + std::to_string(prof.dropped()) + '\n';
+    profileText_.setString(s);
+}
+#endif
 
-    clearText_.setCharacterSize(14);
-    clearText_.setFillColor(sf::Color::Yellow);
-    clearText_.setString("LEVEL CLEAR!\nPress Space");
-    auto r = clearText_.getLocalBounds();
-    clearText_.setOrigin({RECT_W(r) / 2.f, RECT_H(r) / 2.f});
-    clearText_.setPosition({window_.getSize().x / 2.f,
-                            window_.getSize().y / 2.f});
+// HUD; the text only changes, and allocates, when the score or lives do
+void Game::drawHud(sf::RenderTarget& rt, const SimSnapshot& s)
+{
+    PROFILE_SCOPE(Phase::Hud);
+    char line[32];
+    if (s.score != hudScore_) {
+        hudScore_ = s.score;
+        std::snprintf(line, sizeof line, "SCORE  %u", s.score);
+        scoreText_.setString(line);
+    }
+    if (s.lives != hudLives_) {
+        hudLives_ = s.lives;
+        std::snprintf(line, sizeof line, "LIVES %d", s.lives);
+        livesText_.setString(line);
+    }
+    rt.draw(scoreText_);
+    rt.draw(livesText_);
+}
 
-    gameOverText_.setFont(hudFont_);
-    gameOverText_.setCharacterSize(14);
-    gameOverText_.setFillColor(sf::Color::Yellow);
-    gameOverText_.setString("GAME OVER\nPress Space");
-    r = gameOverText_.getLocalBounds();
-    gameOverText_.setOrigin({RECT_W(r) / 2.f, RECT_H(r) / 2.f});
-    gameOverText_.setPosition({window_.getSize().x / 2.f,
-                               window_.getSize().y / 2.f});
+// window events; false once the window was closed
+bool Game::pollEvents()
+{
+    PROFILE_SCOPE(Phase::Events);
+    using K = sf::Keyboard::Key;
+#if SFML_VERSION_MAJOR >= 3
+    while (auto evOpt = window_.pollEvent())
+    {
+        const sf::Event& ev = *evOpt;
+        const bool closed = ev.is<sf::Event::Closed>();
+        const auto* key   = ev.getIf<sf::Event::KeyPressed>();
+        const K     code  = key ? key->code : K::Unknown;
+#else
+    sf::Event ev;
+    while (window_.pollEvent(ev))
+    {
+        const bool closed = ev.type == sf::Event::Closed;
+        const K    code   = ev.type == sf::Event::KeyPressed ? ev.key.code : K::Unknown;
+#endif
+        if (closed) {
+            simThread_.request_stop();
+            simThread_.join();
+            recorder_.finish(sim_);
+#ifdef PACMAN_PROFILE
+            Profiler::get().closeTrace();
+#endif
+            window_.close();
+            return false;
+        }
+
+        // applied on the next tick so the restart lands in the input log
+        if (code == K::Space && frames_.front().finished())
+            restartPending_.store(true, std::memory_order_relaxed);
+#ifdef PACMAN_PROFILE
+        if (code == K::F3)
+            showProfile_ = !showProfile_;
+#endif
+    }
+    return true;
 }
 
-// HUD
-void Game::drawHud()
+// copies the state after the tick due at dueNs out for the window thread
+void Game::publish(std::uint64_t dueNs)
 {
-    sf::Text t(TEXT_CTOR(hudFont_, ""));
-    t.setCharacterSize(12);
-    t.setFillColor(sf::Color::White);
-    t.setString("SCORE  " + std::to_string(score_));
-    t.setPosition({4.f, float(level_.height() * TILE - 14)});
-    window_.draw(t);
+    frames_.back().captureAfter(sim_, dueNs);
+    frames_.publish();
+}
 
-    sf::Text l(TEXT_CTOR(hudFont_, ""));
-    l.setCharacterSize(12);
-    l.setFillColor(sf::Color::White);
-    l.setString("LIVES " + std::to_string(lives_));
-    l.setPosition({float(level_.width()*TILE - 96), float(level_.height()*TILE - 14)});
-    window_.draw(l);
+// simulation thread: one tick per TICK_DT, or back to back when replaying
+// --uncapped; each tick is published as a snapshot
+void Game::simLoop(std::stop_token stop)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto dt     = std::chrono::nanoseconds(1'000'000'000 / Simulation::TICK_HZ);
+    const auto maxLag = std::chrono::milliseconds(250);
+    bool replaying = !opts_.replay.empty();
+    auto due = Clock::now() + dt;
+
+    while (!stop.stop_requested()) {
+        if (replaying && opts_.uncapped)
+            due = Clock::now();
+        else {
+            std::this_thread::sleep_until(due);
+            // a long stall drops the ticks it missed rather than fast-forward the game
+            if (Clock::now() - due > maxLag) due = Clock::now();
+        }
+
+        frames_.back().captureBefore(sim_);
+        if (replaying) {
+            Input in;
+            replaying = replay_.next(in);
+            if (replaying) playSounds(sim_.step(in));
+            else           reportReplay();
+        }
+        else {
+            // a pending restart is consumed by exactly one tick
+            Input in{heldDir_.load(std::memory_order_relaxed),
+                     restartPending_.exchange(false, std::memory_order_relaxed)};
+            tick(in);
+        }
+        publish(std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            due.time_since_epoch()).count()));
+        due += dt;
+    }
 }
 
-// main loop
-void Game::run()
+// how far the display is from the snapshot's `from` to its `to`: the
+// snapshot's tick is shown one tick after it was due, which always leaves
+// a newer one to move towards
+float Game::interpolation(const SimSnapshot& s) const
 {
-    while (window_.isOpen())
+    const double t = double(Profiler::now()) - double(s.dueNs);
+    return float(std::clamp(t * Simulation::TICK_HZ / 1e9, 0.0, 1.0));
+}
+
+// maze, bodies and HUD of one snapshot, in the window or offscreen
+void Game::drawFrame(sf::RenderTarget& rt, const SimSnapshot& s, float alpha)
+{
+    rt.clear();
+    followPlayer(s.player.at(alpha));
+    rt.setView(camera_);
     {
+        PROFILE_SCOPE(Phase::LevelDraw);
+        levelView_.draw(rt, s.pellets);
+    }
+    {
+        PROFILE_SCOPE(Phase::EntityDraw);
+        entities_.clear();
+        entities_.add(s, alpha);
+        entities_.draw(rt);
+    }
+    rt.setView(rt.getDefaultView());
+    drawHud(rt, s);
+    if (s.levelCleared) rt.draw(clearText_);
+    if (s.gameOver)     rt.draw(gameOverText_);
+}
 
-#if SFML_VERSION_MAJOR >= 3
-        while (auto evOpt = window_.pollEvent())
-        {
-            const sf::Event& ev = *evOpt;
-            if (ev.is<sf::Event::Closed>()) {
-                window_.close();
-                return;
-            }
+// --capture: no window and no simulation thread. Every tick is drawn
+// offscreen as one frame and handed to FrameCapture, at TICK_HZ or, with
+// --uncapped, back to back as fast as drawing and encoding allow. Without
+// a replay a bot plays, turning every half second.
+void Game::runCapture()
+{
+    using Clock = std::chrono::steady_clock;
+    FrameCapture capture(opts_.capture, viewSize(), Simulation::TICK_HZ);
+    SimSnapshot  s;
+    s.reserve(sim_);
 
-            if ((levelCleared_ || gameOver_)
-                && ev.is<sf::Event::KeyPressed>()
-                && ev.getIf<sf::Event::KeyPressed>()->code == sf::Keyboard::Key::Space)
-            {
-#else
-        sf::Event ev;
-        while (window_.pollEvent(ev))
-        {
-            if (ev.type == sf::Event::Closed) {
-                window_.close();
-                return;
-            }
+    const bool replaying = !opts_.replay.empty();
+    const std::uint64_t frames = opts_.frames ? opts_.frames
+                               : replaying    ? ~std::uint64_t(0)
+                                              : std::uint64_t(Simulation::TICK_HZ) * 60;
+    std::mt19937 bot(unsigned(sim_.seed()));
+    std::uniform_int_distribution<int> pick(1, 4);
+    Input in;
 
-            if ((levelCleared_ || gameOver_)
-                && ev.type == sf::Event::KeyPressed
-                && ev.key.code == sf::Keyboard::Space)
-            {
-#endif
-                level_.resetPellets();
-                player_.reset();
-                for(auto& g:ghosts_) g.reset();
-                score_        = 0;
-                lives_        = 3;
-                levelCleared_ = false;
-                gameOver_     = false;
-
-                deathSnd_.stop();
-                gameOverSnd_.stop();
-                winSnd_.stop();
-                startSnd_.play();
-                siren_.play();
+    const auto dt = std::chrono::nanoseconds(1'000'000'000 / Simulation::TICK_HZ);
+    const auto t0 = Clock::now();
+    for (std::uint64_t f = 0; f < frames; ++f) {
+        if (!opts_.uncapped) std::this_thread::sleep_until(t0 + dt * f);
+        s.captureBefore(sim_);
+        if (replaying) {
+            if (!replay_.next(in)) {
+                reportReplay();
+                break;
             }
+            sim_.step(in);
+        } else {
+            if (f % (Simulation::TICK_HZ / 2) == 0) in.dir = static_cast<Dir>(pick(bot));
+            in.restart = sim_.finished();
+            tick(in);
         }
+        s.captureAfter(sim_, 0);
+        drawFrame(capture.target(), s, 1.f);
+        capture.submit();
+#ifdef PACMAN_PROFILE
+        Profiler::get().collect();
+#endif
+    }
+    capture.finish();
+    recorder_.finish(sim_);
+#ifdef PACMAN_PROFILE
+    Profiler::get().closeTrace();
+#endif
 
-        if (!levelCleared_ && !gameOver_)
-        {
-            player_.handleInput();
-            player_.update(level_);
-            for(auto& g:ghosts_) g.update(level_, player_.position());
-
-            for(auto& g:ghosts_){
-                sf::Vector2f d = g.position() - player_.position();
-                if(std::hypot(d.x,d.y) < COLL_RADIUS*2){
-                    lives_--;
-                    deathSnd_.play();
-                    if(lives_ <= 0){
-                        gameOver_ = true;
-                        siren_.stop();
-                        gameOverSnd_.play();
-                    }
-                    player_.reset();
-                    for(auto& g:ghosts_) g.reset();
-                    break;
-                }
-            }
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    const double fps  = secs > 0 ? capture.frames() / secs : 0;
+    std::clog << "captured " << capture.frames() << " frames to " << opts_.capture
+              << " in " << secs << " s: " << fps << " fps, "
+              << fps / Simulation::TICK_HZ << "x real time, "
+              << capture.stalls() << " waits for the encoders\n";
+}
 
-            if (!level_.pelletsRemaining())
-            {
-                levelCleared_ = true;
-                siren_.stop();
-                winSnd_.play();
-            }
-        }
+// window thread: input and drawing only
+void Game::run()
+{
+    if (capturing()) {
+        runCapture();
+        return;
+    }
+    frames_.forEachSlot([this](SimSnapshot& s) { s.reserve(sim_); s.captureBefore(sim_); });
+    publish(Profiler::now());
+    frames_.update();
+    simThread_ = std::jthread([this](std::stop_token stop) { simLoop(stop); });
+#ifdef PACMAN_COUNT_ALLOCS
+    // both threads, once the first ALLOC_WARMUP frames have built every cache
+    constexpr std::uint64_t ALLOC_WARMUP = 600;
+    std::uint64_t frame = 0, allocBase = 0;
+#endif
 
-        window_.clear();
-        level_.draw(window_);
-        for(auto& g:ghosts_) g.draw(window_);
-        player_.draw(window_);
-        drawHud();
-        if (levelCleared_) window_.draw(clearText_);
-        if (gameOver_)    window_.draw(gameOverText_);
-        window_.display();
+    while (window_.isOpen())
+    {
+#ifdef PACMAN_COUNT_ALLOCS
+        if (++frame == ALLOC_WARMUP) allocBase = alloccount::allocations();
+#endif
+        if (!pollEvents()) break;
+        readInput();
+        frames_.update();
+        const SimSnapshot& s     = frames_.front();
+        const float        alpha = interpolation(s);
+
+        drawFrame(window_, s, alpha);
+#ifdef PACMAN_PROFILE
+        if (showProfile_) window_.draw(profileText_);
+#endif
+        {
+            PROFILE_SCOPE(Phase::Display);
+            window_.display();
+        }
+#ifdef PACMAN_PROFILE
+        updateProfile();
+#endif
     }
-}
\ No newline at end of file
+#ifdef PACMAN_COUNT_ALLOCS
+    if (frame > ALLOC_WARMUP)
+        std::clog << alloccount::allocations() - allocBase << " allocations in the last "
+                  << frame - ALLOC_WARMUP << " frames\n";
+#endif
+}
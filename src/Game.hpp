@@ -1,37 +1,115 @@
 #pragma once
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
-#include "Level.hpp"
-#include "Player.hpp"
-#include "Ghost.hpp"
+#include "AssetManager.hpp"
+#include "AudioMixer.hpp"
+#include "Simulation.hpp"
+#include "LevelView.hpp"
+#include "EntityRenderer.hpp"
+#include "InputLog.hpp"
+#include "GameState.hpp"
+#include "Profiler.hpp"
+#include "SimSnapshot.hpp"
+#include "TripleBuffer.hpp"
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
 #include <vector>
 
+struct GameOptions {
+    std::optional<std::uint64_t> seed;   // random per session when unset
+    std::string record;                  // write every tick's input here
+    std::string replay;                  // play a recorded session back
+    bool        uncapped{false};         // replay or capture as fast as possible
+    std::string trace;                   // Chrome trace-event JSON of every phase
+    int         ghosts{0};               // 0: the level's setting or the classic four
+    std::string level{"level1"};         // a built-in level or a maze file
+    std::string capture;                 // no window: frames into a .y4m stream or a PNG directory
+    std::uint64_t frames{0};             // capture length; 0: the replay, or a minute
+};
+
 class Game {
 public:
-    Game();
+    Game(AssetManager& assets, const GameOptions& opts = {});
     void run();
 
 private:
-    Level            level_;
+    AssetManager&    assets_;
+    GameOptions      opts_;
+    InputReplay      replay_;            // opened before sim_ since it holds the session
+    InputRecorder    recorder_;
+    Simulation       sim_;
+    LevelView        levelView_;
+    EntityRenderer   entities_;
     sf::RenderWindow window_;
-    Player           player_;
-    std::vector<Ghost> ghosts_;
 
-    sf::Font hudFont_;
-    unsigned score_{0};
-    int      lives_{3};
-    bool     gameOver_{false};
+    // the window shows at most the classic board; bigger mazes scroll with
+    // the player
+    static constexpr int VIEW_TILES_X = 28, VIEW_TILES_Y = 31;
+    sf::View camera_;
 
-    bool    levelCleared_{false};
+    const sf::Font& hudFont_;
     sf::Text clearText_;
     sf::Text gameOverText_;
 
-    sf::Sound startSnd_;
+    // retained HUD lines, re-laid out only when their value changes
+    sf::Text      scoreText_;
+    sf::Text      livesText_;
+    unsigned      hudScore_{~0u};
+    int           hudLives_{-1};
+
+    // every sound goes through one software-mixed stream
+    static constexpr std::uint8_t SIREN_VOLUME = 40;
+    static constexpr std::uint8_t MUNCH_VOLUME = 90;
+    AudioMixer mixer_;                       // fed by the simulation thread once it runs
+    int        munchId_{0};                  // alternate munch1/munch2
+
+    // hold Backspace to walk back through the last ten seconds; off while
+    // recording since the log only holds forward inputs, and in stress runs
+    using Rewind = RewindRing<Simulation::TICK_HZ * 10>;
+    std::unique_ptr<Rewind> rewind_{std::make_unique<Rewind>()};
+    GameState               snapshot_{};
+
+    // The simulation runs on its own thread at TICK_HZ and publishes a
+    // snapshot of every tick; the window thread reads input and draws the
+    // newest snapshot, interpolated, at whatever rate the display runs.
+    // Past construction only the simulation thread touches sim_, the
+    // input logs, the rewind ring and the mixer; the window thread reads
+    // the level's fixed geometry and the atomics below.
+    TripleBuffer<SimSnapshot> frames_;
+    std::atomic<Dir>  heldDir_{Dir::None};
+    std::atomic<bool> restartPending_{false};   // Space seen since the last tick
+    std::atomic<bool> rewindHeld_{false};
+
+    Simulation    openSession();
+    bool capturing() const { return !opts_.capture.empty(); }
+    sf::Vector2u viewSize() const;
+    void  followPlayer(Vec2 player);
+    bool  pollEvents();
+    void  readInput();
+    void  simLoop(std::stop_token stop);
+    void  tick(const Input& in);
+    void  publish(std::uint64_t dueNs);
+    bool  rewindable() const;
+    bool  rewinding() const;
+    void  reportReplay();
+    float interpolation(const SimSnapshot& s) const;
 
-    sf::Sound siren_;
-    sf::Sound deathSnd_;
-    sf::Sound gameOverSnd_;
-    sf::Sound winSnd_;
+#ifdef PACMAN_PROFILE
+    // F3 toggles p50/p99 per phase, refreshed a few times a second
+    static constexpr int PROFILE_REFRESH = 15;
+    sf::Text profileText_;
+    bool     showProfile_{false};
+    int      profileFrame_{0};
+    void     updateProfile();
+#endif
+    void  playSounds(unsigned events);
+    void  drawFrame(sf::RenderTarget& rt, const SimSnapshot& s, float alpha);
+    void  drawHud(sf::RenderTarget& rt, const SimSnapshot& s);
+    void  runCapture();
 
-    void drawHud();
+    std::jthread simThread_;                 // last, so it is joined first
 };
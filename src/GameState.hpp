@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "Simulation.hpp"
+
+// the complete mutable state of a Simulation as one trivially copyable
+// block: saving or restoring a tick is a few hundred bytes of copying and
+// never touches the heap. Level geometry, the distance table and the seed
+// are fixed per session and are not part of it.
+struct GameState {
+    // 32 words cover a padded board of 2048 tiles; level1 uses 16
+    static constexpr std::size_t MAX_PELLET_WORDS = 32;
+
+    std::uint64_t tick;
+    std::uint64_t rng;
+    std::uint32_t score;
+    std::int32_t  lives;
+    bool          gameOver;
+    bool          levelCleared;
+    Player::State player;
+    Ghost::State  ghosts[Simulation::GHOSTS];
+    std::uint64_t pellets[MAX_PELLET_WORDS];
+};
+
+static_assert(std::is_trivially_copyable_v<GameState>);
+static_assert(sizeof(GameState) <= 512);
+
+// the last N snapshots, oldest overwritten first. Storage is inline, so a
+// ring of 600 (ten seconds at 60 Hz) is about 200 KB and pushing or
+// popping is a single copy.
+template<std::size_t N>
+class RewindRing {
+public:
+    static constexpr std::size_t CAPACITY = N;
+
+    void push(const GameState& s)
+    {
+        buf_[head_] = s;
+        head_ = (head_ + 1) % N;
+        if (size_ < N) ++size_;
+    }
+
+    // drops the newest snapshot into out; false when empty
+    bool pop(GameState& out)
+    {
+        if (size_ == 0) return false;
+        head_ = (head_ + N - 1) % N;
+        --size_;
+        out = buf_[head_];
+        return true;
+    }
+
+    // age 0 is the newest snapshot, size()-1 the oldest
+    const GameState& back(std::size_t age = 0) const { return buf_[(head_ + N - 1 - age) % N]; }
+
+    std::size_t size()  const { return size_; }
+    bool        empty() const { return size_ == 0; }
+    void        clear()       { head_ = size_ = 0; }
+
+private:
+    std::array<GameState, N> buf_{};
+    std::size_t head_{0}, size_{0};
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+// plain vector types so the simulation does not depend on SFML
+struct Vec2 {
+    float x{0.f}, y{0.f};
+
+    Vec2& operator+=(Vec2 o) { x += o.x; y += o.y; return *this; }
+    friend Vec2 operator+(Vec2 a, Vec2 b) { return {a.x + b.x, a.y + b.y}; }
+    friend Vec2 operator-(Vec2 a, Vec2 b) { return {a.x - b.x, a.y - b.y}; }
+    friend bool operator==(Vec2 a, Vec2 b) { return a.x == b.x && a.y == b.y; }
+};
+
+struct Vec2i {
+    int x{0}, y{0};
+    friend constexpr bool operator==(Vec2i a, Vec2i b) { return a.x == b.x && a.y == b.y; }
+};
+
+// simulation positions in fixed point (see SUBPX in Constants.hpp), so
+// movement is integer arithmetic and identical on every compiler
+struct Fixed2 {
+    std::int32_t x{0}, y{0};
+
+    Fixed2& operator+=(Fixed2 o) { x += o.x; y += o.y; return *this; }
+    friend constexpr Fixed2 operator+(Fixed2 a, Fixed2 b) { return {a.x + b.x, a.y + b.y}; }
+    friend constexpr Fixed2 operator-(Fixed2 a, Fixed2 b) { return {a.x - b.x, a.y - b.y}; }
+    friend constexpr bool operator==(Fixed2 a, Fixed2 b) { return a.x == b.x && a.y == b.y; }
+};
+
+enum class Dir : std::uint8_t { None, Left, Right, Up, Down };
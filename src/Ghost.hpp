@@ -1,24 +1,150 @@
 #pragma once
-#include <SFML/Graphics.hpp>
-#include <random>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
 #include "Level.hpp"
 #include "Constants.hpp"
+#include "Geometry.hpp"
+#include "GhostPolicy.hpp"
+#include "Movement.hpp"
+#include "Random.hpp"
 
 class Ghost {
 public:
-    Ghost(sf::Color color, sf::Vector2f start);
+    // the per-tick part of a ghost, for snapshots; start and color are fixed
+    struct State {
+        Fixed2 pos;
+        Dir  curDir;
+        bool onTeleport;
+    };
+
+    Ghost(std::uint32_t rgba, Fixed2 start);
     void reset();
-    void update(const Level& lvl, const sf::Vector2f& target);
-    void draw(sf::RenderTarget& rt) const { rt.draw(sprite_); }
-    sf::Vector2f position() const { return sprite_.getPosition(); }
-private:
-    enum class Dir {Left,Right,Up,Down};
-    sf::Vector2f dirVec(Dir d) const;
-    bool canMove(const Level& lvl, const sf::Vector2f& pos) const;
-    static Dir opposite(Dir d);
+    // one tick; Policy (see GhostPolicy.hpp) picks the target at junctions
+    template<class Policy>
+    void update(const Level& lvl, const ghostai::Hunt& hunt, SplitMix64& rng);
+    Fixed2 position() const { return pos_; }
+    std::uint32_t color() const { return color_; }
+    std::uint64_t tableHits() const { return tableHits_; }   // decisions served by the all-pairs table
+    std::uint64_t decisions() const { return decisions_; }   // real choices, at junctions
+    std::uint64_t corridorTurns() const { return corridorTurns_; }   // tile centres with one way on
+
+    State save() const { return {pos_, curDir_, onTeleport_}; }
+    void  restore(const State& s) { pos_ = s.pos; curDir_ = s.curDir; onTeleport_ = s.onTeleport; }
+
+    // true when a ghost at pos heading cur must pick a new direction
+    static bool needsDecision(const Level& lvl, Fixed2 pos, Dir cur)
+    {
+        const Fixed2 center = tileCenter(tileOf(pos));
+        const bool atCenter = std::abs(center.x - pos.x) < SUBPX && std::abs(center.y - pos.y) < SUBPX;
+        return atCenter || !canMove(lvl, pos, cur);
+    }
 
-    sf::CircleShape sprite_;
-    sf::Vector2f start_;
+    // the one heading a ghost at pos heading cur can take without a choice
+    // (straights and two-exit bends alike, as reversing is never allowed;
+    // a dead end leaves only the way back), or Dir::None at a junction,
+    // where it has to decide()
+    static Dir corridorHeading(const Level& lvl, Fixed2 pos, Dir cur)
+    {
+        const Vec2i t = tileOf(pos);
+        const unsigned out = lvl.moves(t.x, t.y) & ~Level::exitBit(opposite(cur));
+        if (out == 0) return opposite(cur);               // dead end: the way back is the only exit
+        if (out & (out - 1)) return Dir::None;
+        return Dir(std::countr_zero(out));
+    }
+
+    // chase the target tile, never reversing, with a random turn in
+    // wander tenths of the decisions.
+    // Rng must return 64-bit words; all draws are portable (see Random.hpp)
+    template<class Rng>
+    static Dir decide(const Level& lvl, Fixed2 pos, Dir cur, Fixed2 target, Rng& rng,
+                      std::uint32_t wander = ghostai::Chase::WANDER);
+
+private:
+    Fixed2 pos_;
+    Fixed2 start_;
+    std::uint32_t color_;
     Dir curDir_{Dir::Left};
     bool onTeleport_ = false;
+    std::uint64_t tableHits_{0};
+    std::uint64_t decisions_{0};
+    std::uint64_t corridorTurns_{0};
 };
+
+template<class Policy>
+void Ghost::update(const Level& lvl, const ghostai::Hunt& hunt, SplitMix64& rng)
+{
+    if(needsDecision(lvl, pos_, curDir_)){
+        // along a corridor there is nothing to choose: only junctions
+        // ask the policy, shuffle, look up distances and draw from the rng
+        Dir d = corridorHeading(lvl, pos_, curDir_);
+        if(d != Dir::None){
+            ++corridorTurns_;
+            curDir_ = d;
+        } else {
+            ++decisions_;
+            if(lvl.hasDistanceTable()) ++tableHits_;
+            const Vec2i target = Policy::target(lvl, hunt, tileOf(pos_));
+            curDir_ = decide(lvl, pos_, curDir_, tileCenter(target), rng, Policy::WANDER);
+        }
+    }
+
+    pos_ += dirStep(curDir_);
+    wrapAndTeleport(lvl, pos_, onTeleport_);
+}
+
+template<class Rng>
+Dir Ghost::decide(const Level& lvl, Fixed2 pos, Dir cur, Fixed2 target, Rng& rng, std::uint32_t wander)
+{
+    const Vec2i g = tileOf(pos);
+    const std::uint8_t legal = lvl.moves(g.x, g.y);   // canMove from the tile centre
+
+    Dir order[4]{Dir::Left,Dir::Right,Dir::Up,Dir::Down};
+    shuffleArray(rng, order);
+
+    const Vec2i pg = tileOf(target);
+
+    // the moves worth weighing, in shuffled order
+    Dir    cand[4];
+    Vec2i  next[4];
+    int    n = 0;
+    for(auto nd:order){
+        if(nd==opposite(cur)) continue;
+        if(!(legal & Level::exitBit(nd))) continue;
+        Fixed2 s = dirStep(nd);
+        cand[n] = nd;
+        next[n++] = {g.x+(s.x>0)-(s.x<0), g.y+(s.y>0)-(s.y<0)};
+    }
+
+    // distances to the player come from the level's all-pairs table;
+    // mazes too big for it ask the cluster hierarchy, once for all moves
+    std::uint32_t cost[4];
+    if(lvl.hasDistanceTable()){
+        for(int i=0;i<n;++i){
+            std::uint16_t d = lvl.distance(pg,next[i]);
+            cost[i] = d != Level::UNREACHABLE ? d : PathHierarchy::UNREACHABLE;
+        }
+    } else
+        lvl.paths().distances(lvl, pg, next, n, cost);
+
+    Dir bestDir = cur;
+    int bestCost = std::numeric_limits<int>::max();
+    for(int i=0;i<n;++i){
+        if(cost[i] != PathHierarchy::UNREACHABLE && int(cost[i]) < bestCost){
+            bestCost = int(cost[i]);
+            bestDir = cand[i];
+        }
+    }
+
+    if(randomChance(rng, wander, 10) || bestCost==std::numeric_limits<int>::max()){
+        for(auto nd:order){
+            if(nd==opposite(cur)) continue;
+            if(legal & Level::exitBit(nd)){
+                bestDir = nd;
+                break;
+            }
+        }
+    }
+    return bestDir;
+}
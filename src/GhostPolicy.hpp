@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include "Level.hpp"
+#include "Movement.hpp"
+
+// ghost behaviours as compile-time policies.
+// A policy only says where a ghost heads when it reaches a junction; the
+// movement, the never-reverse rule and the distance lookups are shared in
+// Ghost. Ghost::update is instantiated per policy, so targeting inlines
+// into it, and callers run ghosts of one kind as a batch: the policy is
+// picked once per batch and there is no per-ghost dispatch.
+namespace ghostai {
+
+// the classic four, in the order of Simulation::GHOST_COLOR
+enum class Kind : std::uint8_t { Chase, Patrol, Ambush, Scatter, Count };
+inline constexpr int KINDS = int(Kind::Count);
+
+constexpr Kind kindOf(std::size_t ghost) { return Kind(ghost % KINDS); }
+
+// what targeting looks at, gathered once per tick
+struct Hunt {
+    Vec2i player;       // tile
+    Dir   facing;       // the player's
+};
+
+// red: straight for the player
+struct Chase {
+    static constexpr Kind          KIND   = Kind::Chase;
+    static constexpr std::uint32_t WANDER = 3;        // tenths of decisions taken at random
+
+    static Vec2i target(const Level&, const Hunt& h, Vec2i) { return h.player; }
+};
+
+// cyan: guards the corner of the quadrant the player is in
+struct Patrol {
+    static constexpr Kind          KIND   = Kind::Patrol;
+    static constexpr std::uint32_t WANDER = 3;
+
+    static Vec2i target(const Level& lvl, const Hunt& h, Vec2i)
+    {
+        const int right = 2 * h.player.x >= lvl.width(), down = 2 * h.player.y >= lvl.height();
+        return lvl.corner(down * 2 + right);
+    }
+};
+
+// magenta: where the player would be AHEAD tiles on, short of any wall
+struct Ambush {
+    static constexpr Kind          KIND   = Kind::Ambush;
+    static constexpr std::uint32_t WANDER = 3;
+    static constexpr int           AHEAD  = 4;
+
+    static Vec2i target(const Level& lvl, const Hunt& h, Vec2i)
+    {
+        const Fixed2 s = dirStep(h.facing);
+        const int dx = (s.x > 0) - (s.x < 0), dy = (s.y > 0) - (s.y < 0);
+        Vec2i t = h.player;
+        for (int i = 0; i < AHEAD && lvl.moves(t.x + dx, t.y + dy); ++i) t = {t.x + dx, t.y + dy};
+        return t;
+    }
+};
+
+// orange: chases from afar, but within SHY tiles of the player backs off
+// to the bottom-left corner
+struct Scatter {
+    static constexpr Kind          KIND   = Kind::Scatter;
+    static constexpr std::uint32_t WANDER = 3;
+    static constexpr int           SHY    = 8;
+
+    static Vec2i target(const Level& lvl, const Hunt& h, Vec2i self)
+    {
+        const int d = std::abs(self.x - h.player.x) + std::abs(self.y - h.player.y);
+        return d > SHY ? h.player : lvl.corner(2);
+    }
+};
+
+// calls f(Policy{}) for kind's policy
+template<class F>
+void withPolicy(Kind k, F&& f)
+{
+    switch (k) {
+        case Kind::Chase:   f(Chase{});   break;
+        case Kind::Patrol:  f(Patrol{});  break;
+        case Kind::Ambush:  f(Ambush{});  break;
+        case Kind::Scatter: f(Scatter{}); break;
+        case Kind::Count:   break;
+    }
+}
+
+}
@@ -0,0 +1,560 @@
+#include "AllocCounter.hpp"
+#include "BatchEnv.hpp"
+#include "GameState.hpp"
+#include "InputLog.hpp"
+#include "MatchClient.hpp"
+#include "MatchServer.hpp"
+#include "ShmEnv.hpp"
+#include "Simulation.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// random bot: pick a new direction every half second
+static constexpr int BOT_PERIOD = Simulation::TICK_HZ / 2;
+
+static double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ghost count and collision method of a single-game run
+struct Stress {
+    int           ghosts{0};           // 0: the level's setting or Simulation::GHOSTS
+    CollisionMode collision{CollisionMode::BruteForce};
+};
+
+static int runSingle(const std::string& level, std::uint64_t steps, unsigned seed,
+                     const std::string& record, Stress stress)
+{
+    Simulation sim(level, seed, stress.ghosts);
+    sim.setCollisionMode(stress.collision);
+    InputRecorder rec;
+    if (!record.empty() && !rec.open(record, inputlog::Session::of(sim, level))) {
+        std::cerr << "ERROR: cannot write " << record << '\n';
+        return 1;
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(1, 4);
+    Input in;
+
+    std::uint64_t games = 0, best = 0;
+#ifdef PACMAN_COUNT_ALLOCS
+    // from the tenth second on, once every lazily grown buffer has grown
+    const std::uint64_t allocWarmup = Simulation::TICK_HZ * 10;
+    std::uint64_t allocBase = alloccount::allocations();
+#endif
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < steps; ++i) {
+#ifdef PACMAN_COUNT_ALLOCS
+        if (i == allocWarmup) allocBase = alloccount::allocations();
+#endif
+        if (i % BOT_PERIOD == 0)
+            in.dir = static_cast<Dir>(pick(rng));
+        in.restart = sim.finished();
+        if (in.restart) {
+            ++games;
+            if (sim.score() > best) best = sim.score();
+        }
+        rec.record(in);
+        sim.step(in);
+    }
+    double secs = secondsSince(t0);
+    rec.finish(sim);
+
+    std::cout << "steps        " << steps << '\n'
+              << "ghosts       " << sim.ghosts().size() << '\n'
+              << "games        " << games << '\n'
+              << "best score   " << best << '\n'
+              << "final score  " << sim.score() << '\n'
+              << "checksum     " << std::hex << sim.checksum() << std::dec << '\n'
+              << "decisions    " << sim.ghostDecisions() << " (" << sim.corridorTurns() << " corridor tiles skipped)\n"
+              << "from table   " << sim.tableDecisions() << '\n'
+              << "seconds      " << secs << '\n'
+              << "steps/sec    " << (secs > 0 ? steps / secs : 0) << '\n'
+              << "x real time  " << (secs > 0 ? steps / secs / Simulation::TICK_HZ : 0) << '\n';
+#ifdef PACMAN_COUNT_ALLOCS
+    std::cout << "allocations  " << alloccount::allocations() - allocBase
+              << (steps > allocWarmup ? " (after the tenth second)\n" : " (whole run)\n");
+#endif
+    return 0;
+}
+
+// feeds a recorded session back through step() uncapped and checks that
+// the final state matches the recording. The log says how to build the
+// Simulation; a --level (non-empty level), --ghosts or --collision given
+// as well must agree with it.
+static int runReplay(const std::string& file, const std::string& level, Stress stress, bool collisionGiven)
+{
+    InputReplay log;
+    if (!log.open(file)) {
+        std::cerr << "ERROR: cannot read input log " << file << '\n';
+        return 1;
+    }
+    const inputlog::Session& rec = log.session();
+    if ((!level.empty() && level != rec.level) || (stress.ghosts > 0 && std::uint32_t(stress.ghosts) != rec.ghosts)
+        || (collisionGiven && stress.collision != rec.collision)) {
+        std::cerr << "ERROR: " << file << " was recorded with --level " << rec.level
+                  << " --ghosts " << rec.ghosts << " --collision "
+                  << (rec.collision == CollisionMode::SpatialHash ? "hash" : "brute") << '\n';
+        return 1;
+    }
+    Simulation sim(rec.level, rec.seed, int(rec.ghosts));
+    sim.setCollisionMode(rec.collision);
+
+    Input in;
+    auto t0 = std::chrono::steady_clock::now();
+    while (log.next(in)) sim.step(in);
+    double secs = secondsSince(t0);
+
+    std::cout << "ticks        " << sim.tick() << '\n'
+              << "final score  " << sim.score() << '\n'
+              << "checksum     " << std::hex << sim.checksum() << std::dec << '\n'
+              << "seconds      " << secs << '\n'
+              << "x real time  " << (secs > 0 ? sim.tick() / secs / Simulation::TICK_HZ : 0) << '\n';
+
+    if (!log.hasTrailer()) {
+        std::cout << "verify       skipped, recording was not finished\n";
+        return 0;
+    }
+    bool same = sim.tick() == log.expectedTick() && sim.score() == log.expectedScore()
+             && sim.checksum() == log.expectedChecksum();
+    std::cout << "verify       " << (same ? "identical" : "MISMATCH") << '\n';
+    return same ? 0 : 2;
+}
+
+// plays steps ticks keeping the last ten seconds of snapshots, then
+// branches rollouts from the oldest one with differently seeded bots
+static int runRollouts(const std::string& level, std::uint64_t steps, unsigned seed,
+                       int rollouts)
+{
+    using Clock = std::chrono::steady_clock;
+    // the branch point is the oldest saved tick, so there must be one
+    if (steps == 0) {
+        std::cerr << "ERROR: --rollouts needs --steps of at least 1\n";
+        return 1;
+    }
+    Simulation sim(level, seed);
+    auto ring = std::make_unique<RewindRing<Simulation::TICK_HZ * 10>>();
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(1, 4);
+    Input in;
+    GameState s;
+    double saveSecs = 0;
+    for (std::uint64_t i = 0; i < steps; ++i) {
+        if (i % BOT_PERIOD == 0) in.dir = static_cast<Dir>(pick(rng));
+        in.restart = sim.finished();
+        sim.step(in);
+        auto t0 = Clock::now();
+        sim.save(s);
+        ring->push(s);
+        saveSecs += secondsSince(t0);
+    }
+
+    const GameState branch = ring->back(ring->size() - 1);
+    const std::uint64_t horizon = ring->size();
+    auto rollout = [&](int r) {
+        sim.restore(branch);
+        std::mt19937 bot(seed + 1 + r);
+        Input rin;
+        for (std::uint64_t i = 0; i < horizon; ++i) {
+            if (i % BOT_PERIOD == 0) rin.dir = static_cast<Dir>(pick(bot));
+            sim.step(rin);
+        }
+    };
+
+    unsigned best = 0;
+    auto t0 = Clock::now();
+    for (int r = 0; r < rollouts; ++r) {
+        rollout(r);
+        if (sim.score() > best) best = sim.score();
+    }
+    double rollSecs = secondsSince(t0);
+
+    // the same branch and bot must land on the same state
+    rollout(0);
+    std::uint64_t a = sim.checksum();
+    rollout(0);
+    bool same = sim.checksum() == a;
+
+    t0 = Clock::now();
+    const int RESTORES = 100000;
+    for (int i = 0; i < RESTORES; ++i) sim.restore(ring->back(std::size_t(i) % horizon));
+    double restoreSecs = secondsSince(t0);
+
+    std::cout << "snapshot     " << sizeof(GameState) << " bytes\n"
+              << "save         " << saveSecs / steps * 1e9 << " ns\n"
+              << "restore      " << restoreSecs / RESTORES * 1e9 << " ns\n"
+              << "rollouts     " << rollouts << " x " << horizon << " ticks\n"
+              << "best score   " << best << '\n'
+              << "ticks/sec    " << (rollSecs > 0 ? rollouts * horizon / rollSecs : 0) << '\n'
+              << "repeatable   " << (same ? "yes" : "NO") << '\n';
+    return same ? 0 : 2;
+}
+
+static int runBatch(const std::string& level, std::uint64_t steps, unsigned seed,
+                    int envs, unsigned threads)
+{
+    BatchEnv env(level, envs, seed, threads);
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(1, 4);
+    std::vector<Dir> actions(envs, Dir::None);
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < steps; ++i) {
+        if (i % BOT_PERIOD == 0)
+            for (auto& a : actions) a = static_cast<Dir>(pick(rng));
+        env.step(actions.data());
+    }
+    double secs = secondsSince(t0);
+
+    const double envSteps = double(steps) * envs;
+    std::cout << "envs                " << envs << '\n'
+              << "threads             " << env.threads() << '\n'
+              << "batch steps         " << steps << '\n'
+              << "games               " << env.episodes() << '\n'
+              << "seconds             " << secs << '\n'
+              << "env-steps/sec       " << (secs > 0 ? envSteps / secs : 0) << '\n'
+              << "env-steps/sec/core  " << (secs > 0 ? envSteps / secs / env.threads() : 0) << '\n';
+    return 0;
+}
+
+// players and link conditions of a --netsim run
+struct NetSim {
+    int     pacmen{0};
+    int     ghosts{0};             // players taking over a ghost
+    int     sendEvery{1};          // ticks between snapshots
+    LinkSim link;
+};
+
+static std::uint64_t tickMs(std::uint64_t t) { return t * 1000 / Simulation::TICK_HZ; }
+
+// what a client may cost each way at TICK_HZ, IP and UDP headers included
+static constexpr double NET_BUDGET = 2048;
+
+static const char* againstBudget(double bytesPerSec)
+{
+    return bytesPerSec < NET_BUDGET ? "within the 2 KB/s budget" : "OVER the 2 KB/s budget";
+}
+
+// a server and bot clients over loopback in one thread, on a simulated
+// clock so that latency and loss are the only timing there is. Reports
+// what the snapshots cost per client and checks that every client ends
+// up holding exactly the state the server sent.
+static int runNetsim(const std::string& level, std::uint64_t steps, unsigned seed, const NetSim& ns)
+{
+    MatchServer server(Match(Level::open(level), seed), NetAddress::LOOPBACK, 0);
+    server.socket().setLink(ns.link, seed);
+    server.setSendInterval(ns.sendEvery);
+
+    std::vector<std::unique_ptr<MatchClient>> clients;
+    for (int i = 0; i < ns.pacmen + ns.ghosts; ++i) {
+        const Match::Role role = i < ns.pacmen ? Match::Role::PacMan : Match::Role::Ghost;
+        clients.push_back(std::make_unique<MatchClient>(Level::open(level), role));
+        clients.back()->connect(NetAddress::LOOPBACK, server.address());
+        clients.back()->socket().setLink(ns.link, seed + 1 + unsigned(i));
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(1, 4);
+    std::vector<Input> in(clients.size());
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::uint64_t t = 0; t < steps; ++t) {
+        const std::uint64_t now = tickMs(t);
+        server.poll(now);
+        server.tick(now);
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            MatchClient& c = *clients[i];
+            c.poll(now);
+            if (t % BOT_PERIOD == i % BOT_PERIOD) in[i].dir = static_cast<Dir>(pick(rng));
+            in[i].restart = c.latest().flags != 0;
+            c.tick(in[i], now);
+        }
+    }
+    // let the last datagrams land
+    for (std::uint64_t t = steps; t < steps + Simulation::TICK_HZ; ++t) {
+        server.socket().flush(tickMs(t));
+        for (auto& c : clients) c->poll(tickMs(t));
+    }
+    double secs = secondsSince(t0);
+
+    const double played = double(steps) / Simulation::TICK_HZ;
+    const std::vector<MatchServer::Stats> stats = server.stats();
+    bool agree = true;
+    std::cout << "ticks        " << steps << " (" << played << " s played)\n"
+              << "link         " << ns.link.loss * 100 << "% loss, " << ns.link.latencyMs
+              << " ms latency, " << ns.link.jitterMs << " ms jitter\n"
+              << "seconds      " << secs << '\n';
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        const MatchClient& c = *clients[i];
+        std::cout << "client " << i << "     " << (int(i) < ns.pacmen ? "pac-man" : "ghost");
+        if (!c.joined()) {
+            std::cout << (c.refused() ? ", refused\n" : ", never joined\n");
+            continue;
+        }
+        const NetState* sent = server.history(c.latest().tick);
+        const bool same = sent && *sent == c.latest();
+        agree = agree && same;
+        std::cout << ", slot " << c.slot() << '\n';
+        for (const MatchServer::Stats& st : stats) {
+            if (st.slot != c.slot()) continue;
+            const std::uint64_t deltas = st.snapshots - st.fullSnapshots;
+            const double down = double(st.bytesOut + st.datagramsOut * net::IP_UDP_HEADER) / played;
+            const double up   = double(st.bytesIn + st.datagramsIn * net::IP_UDP_HEADER) / played;
+            std::cout << "  down       " << st.bytesOut / played << " B/s, " << down
+                      << " B/s with IP/UDP headers, " << againstBudget(down) << '\n'
+                      << "  up         " << st.bytesIn / played << " B/s, " << up
+                      << " B/s with IP/UDP headers, " << againstBudget(up) << '\n'
+                      << "  per tick   " << double(st.bytesOut) / st.datagramsOut << " B down, "
+                      << double(st.bytesIn) / st.datagramsIn << " B up, before headers\n"
+                      << "  snapshots  " << st.snapshots << " sent, " << st.fullSnapshots << " full, "
+                      << (deltas ? double(st.baseAgeSum) / deltas : 0) << " ticks mean baseline age\n"
+                      << "  inputs     " << st.inputsMissed << " ticks without one\n";
+        }
+        std::cout << "  received   " << c.snapshots() << " snapshots, " << c.undecodable() << " undecodable, "
+                  << c.stale() << " stale\n"
+                  << "  predicted  " << c.corrections() << " corrections\n"
+                  << "  state      " << (same ? "identical to the server's" : "MISMATCH") << '\n';
+    }
+    return agree ? 0 : 2;
+}
+
+// hosts a match on port until killed, at TICK_HZ
+static int runServe(const std::string& level, unsigned seed, std::uint16_t port, const NetSim& ns)
+{
+    using Clock = std::chrono::steady_clock;
+    MatchServer server(Match(Level::open(level), seed), 0, port);
+    server.socket().setLink(ns.link, seed);
+    server.setSendInterval(ns.sendEvery);
+    std::cout << "serving " << level << " on " << server.address().str() << std::endl;
+
+    const auto t0 = Clock::now();
+    const auto period = std::chrono::microseconds(1'000'000 / Simulation::TICK_HZ);
+    int clients = 0;
+    for (std::uint64_t t = 1;; ++t) {
+        const std::uint64_t now = std::uint64_t(secondsSince(t0) * 1000);
+        server.poll(now);
+        server.tick(now);
+        if (server.clients() != clients) {
+            clients = server.clients();
+            std::cout << "tick " << server.match().tick() << ": " << clients << " players" << std::endl;
+        }
+        std::this_thread::sleep_until(t0 + period * t);
+    }
+}
+
+// joins a server as a bot for steps ticks in real time
+static int runConnect(const std::string& level, std::uint64_t steps, unsigned seed,
+                      const NetAddress& server, Match::Role role, const LinkSim& link)
+{
+    using Clock = std::chrono::steady_clock;
+    MatchClient client(Level::open(level), role);
+    client.connect(0, server);
+    client.socket().setLink(link, seed);
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(1, 4);
+    Input in;
+    const auto t0 = Clock::now();
+    const auto period = std::chrono::microseconds(1'000'000 / Simulation::TICK_HZ);
+    for (std::uint64_t t = 1; t <= steps && !client.refused(); ++t) {
+        const std::uint64_t now = std::uint64_t(secondsSince(t0) * 1000);
+        client.poll(now);
+        if (t % BOT_PERIOD == 0) in.dir = static_cast<Dir>(pick(rng));
+        in.restart = client.latest().flags != 0;
+        client.tick(in, now);
+        std::this_thread::sleep_until(t0 + period * t);
+    }
+    const int slot = client.slot();
+    client.disconnect(std::uint64_t(secondsSince(t0) * 1000));
+
+    if (client.refused()) {
+        std::cerr << "ERROR: " << server.str() << " has no free " << (role == Match::Role::PacMan ? "pac-man" : "ghost")
+                  << " slot\n";
+        return 1;
+    }
+    const double secs = secondsSince(t0);
+    std::cout << "slot         " << slot << '\n'
+              << "last tick    " << client.latest().tick << '\n'
+              << "snapshots    " << client.snapshots() << " (" << client.undecodable() << " undecodable, "
+              << client.stale() << " stale)\n"
+              << "corrections  " << client.corrections() << '\n'
+              << "down         " << client.bytesIn() / secs << " B/s\n"
+              << "up           " << client.bytesOut() / secs << " B/s\n";
+    return client.snapshots() ? 0 : 1;
+}
+
+// serves a game over shared memory until the agent leaves or steps run out
+static int runShmEnv(const std::string& level, std::uint64_t steps, unsigned seed,
+                     const std::string& name, Stress stress)
+{
+    Simulation sim(level, seed, stress.ghosts);
+    ShmEnv env(name, sim);
+    std::cout << "waiting for an agent on /dev/shm" << (name[0] == '/' ? "" : "/") << name << std::endl;
+
+    std::chrono::steady_clock::time_point t0;
+    std::uint64_t n = 0;
+    while (n < steps && env.step())
+        if (n++ == 0) t0 = std::chrono::steady_clock::now();   // from the agent's first action
+    env.close();
+    double secs = n ? secondsSince(t0) : 0;
+
+    std::cout << "steps        " << n << '\n'
+              << "final score  " << sim.score() << '\n'
+              << "seconds      " << secs << '\n'
+              << "steps/sec    " << (secs > 0 ? n / secs : 0) << '\n';
+    return 0;
+}
+
+// the random bot as an out-of-process agent, for timing the round trip
+static int runShmAgent(std::uint64_t steps, unsigned seed, const std::string& name)
+{
+    ShmAgent agent(name);
+    const shm::Header& h = agent.header();
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(1, 4);
+    Input in;
+    const shm::Slot* last = nullptr;
+    std::uint64_t n = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (; n < steps; ++n) {
+        const shm::Slot* s = agent.observe();
+        if (!s) break;
+        last = s;
+        if (n % BOT_PERIOD == 0) in.dir = static_cast<Dir>(pick(rng));
+        agent.act(in);
+    }
+    double secs = secondsSince(t0);
+
+    // read straight from the last observation, which the env keeps for
+    // a few more ticks than this
+    unsigned pellets = 0;
+    if (last) {
+        const std::uint8_t* p = agent.plane(*last, shm::PELLETS);
+        for (std::uint32_t i = 0; i < h.width * h.height; ++i) pellets += p[i];
+    }
+    std::cout << "maze         " << h.width << 'x' << h.height << ", " << h.ghosts << " ghosts, "
+              << h.slots << " slots of " << h.slotBytes << " bytes\n"
+              << "steps        " << n << '\n'
+              << "last tick    " << (last ? last->tick : 0) << ", score " << (last ? last->score : 0)
+              << ", " << pellets << " pellets left\n"
+              << "seconds      " << secs << '\n'
+              << "steps/sec    " << (secs > 0 ? n / secs : 0) << '\n';
+    agent.close();
+    return 0;
+}
+
+// runs the simulation without a window as fast as the CPU allows
+// usage: PacManHeadless [--steps N] [--level NAME|FILE] [--seed S]
+//                       [--ghosts N] [--collision brute|hash]
+//                       [--envs N [--threads T]] [--rollouts K]
+//                       [--record LOG | --replay LOG]
+//                       [--netsim N [--net-ghosts K] | --serve PORT |
+//                        --connect HOST:PORT [--role pacman|ghost]]
+//                       [--send-every T] [--loss PCT] [--latency MS] [--jitter MS]
+//                       [--shm NAME | --shm-agent NAME]
+int main(int argc, char** argv)
+{
+    std::uint64_t steps   = 1'000'000;
+    std::string   level   = "level1";     // built-in, or a level file
+    bool          levelGiven = false, collisionGiven = false;
+    unsigned      seed    = 1;
+    int           envs    = 0;
+    unsigned      threads = 0;
+    int           rollouts = 0;
+    Stress        stress;
+    std::string   record, replay;
+    NetSim        net;
+    int           serve = 0;
+    NetAddress    connect;
+    Match::Role   role = Match::Role::PacMan;
+    std::string   shmEnv, shmAgent;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--steps") && i + 1 < argc)
+            steps = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--level") && i + 1 < argc) {
+            level = argv[++i];
+            levelGiven = true;
+        }
+        else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "--envs") && i + 1 < argc)
+            envs = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "--ghosts") && i + 1 < argc)
+            stress.ghosts = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--collision") && i + 1 < argc) {
+            stress.collision = !std::strcmp(argv[++i], "hash") ? CollisionMode::SpatialHash
+                                                               : CollisionMode::BruteForce;
+            collisionGiven = true;
+        }
+        else if (!std::strcmp(argv[i], "--rollouts") && i + 1 < argc)
+            rollouts = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--record") && i + 1 < argc)
+            record = argv[++i];
+        else if (!std::strcmp(argv[i], "--replay") && i + 1 < argc)
+            replay = argv[++i];
+        else if (!std::strcmp(argv[i], "--netsim") && i + 1 < argc)
+            net.pacmen = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--net-ghosts") && i + 1 < argc)
+            net.ghosts = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--send-every") && i + 1 < argc)
+            net.sendEvery = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--loss") && i + 1 < argc)
+            net.link.loss = std::atof(argv[++i]) / 100;
+        else if (!std::strcmp(argv[i], "--latency") && i + 1 < argc)
+            net.link.latencyMs = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--jitter") && i + 1 < argc)
+            net.link.jitterMs = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--serve") && i + 1 < argc)
+            serve = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--connect") && i + 1 < argc && NetAddress::parse(argv[i + 1], connect))
+            ++i;
+        else if (!std::strcmp(argv[i], "--shm") && i + 1 < argc)
+            shmEnv = argv[++i];
+        else if (!std::strcmp(argv[i], "--shm-agent") && i + 1 < argc)
+            shmAgent = argv[++i];
+        else if (!std::strcmp(argv[i], "--role") && i + 1 < argc)
+            role = !std::strcmp(argv[++i], "ghost") ? Match::Role::Ghost : Match::Role::PacMan;
+        else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--steps N] [--level NAME|FILE] [--seed S]"
+                         " [--ghosts N] [--collision brute|hash]"
+                         " [--envs N [--threads T]] [--rollouts K]"
+                         " [--record LOG | --replay LOG]"
+                         " [--netsim N [--net-ghosts K] | --serve PORT |"
+                         " --connect HOST:PORT [--role pacman|ghost]]"
+                         " [--send-every T] [--loss PCT] [--latency MS] [--jitter MS]"
+                         " [--shm NAME | --shm-agent NAME]\n";
+            return 1;
+        }
+    }
+
+    try {
+        if (net.pacmen + net.ghosts > 0) return runNetsim(level, steps, seed, net);
+        if (serve > 0) return runServe(level, seed, std::uint16_t(serve), net);
+        if (connect.port) return runConnect(level, steps, seed, connect, role, net.link);
+        if (!shmEnv.empty()) return runShmEnv(level, steps, seed, shmEnv, stress);
+        if (!shmAgent.empty()) return runShmAgent(steps, seed, shmAgent);
+        if (!replay.empty()) return runReplay(replay, levelGiven ? level : std::string(), stress, collisionGiven);
+        if (rollouts > 0) return runRollouts(level, steps, seed, rollouts);
+        if (envs > 0) return runBatch(level, steps, seed, envs, threads);
+        return runSingle(level, steps, seed, record, stress);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,123 @@
+#include "InputLog.hpp"
+
+namespace {
+template<class T>
+void writeRaw(std::ofstream& out, T v) { out.write(reinterpret_cast<const char*>(&v), sizeof v); }
+
+template<class T>
+bool readRaw(std::ifstream& in, T& v) { return bool(in.read(reinterpret_cast<char*>(&v), sizeof v)); }
+}
+
+// recorder
+
+bool InputRecorder::open(const std::string& path, const inputlog::Session& session)
+{
+    if (session.level.size() > 0xFFFF) return false;
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) return false;
+    writeRaw(out_, inputlog::MAGIC);
+    writeRaw(out_, inputlog::VERSION);
+    writeRaw(out_, session.seed);
+    writeRaw(out_, session.ghosts);
+    writeRaw(out_, std::uint8_t(session.collision));
+    writeRaw(out_, std::uint16_t(session.level.size()));
+    out_.write(session.level.data(), std::streamsize(session.level.size()));
+    run_ = 0;
+    return bool(out_);
+}
+
+void InputRecorder::writeVarint(std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out_.put(char((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out_.put(char(v));
+}
+
+void InputRecorder::flushRun()
+{
+    if (run_ == 0) return;
+    out_.put(char(value_));
+    writeVarint(run_);
+    run_ = 0;
+}
+
+void InputRecorder::record(const Input& in)
+{
+    if (!isOpen()) return;
+    std::uint8_t b = inputlog::pack(in);
+    if (run_ && b != value_) flushRun();
+    value_ = b;
+    ++run_;
+}
+
+void InputRecorder::finish(const Simulation& sim)
+{
+    if (!isOpen()) return;
+    flushRun();
+    out_.put(char(inputlog::END));
+    writeVarint(sim.tick());
+    writeVarint(sim.score());
+    writeRaw(out_, sim.checksum());
+    out_.close();
+}
+
+void InputRecorder::close()
+{
+    if (!isOpen()) return;
+    flushRun();
+    out_.close();
+}
+
+// replay
+
+bool InputReplay::open(const std::string& path)
+{
+    in_.open(path, std::ios::binary);
+    std::uint32_t magic = 0, version = 0;
+    if (!readRaw(in_, magic) || !readRaw(in_, version)
+        || magic != inputlog::MAGIC || version != inputlog::VERSION)
+        return false;
+
+    std::uint8_t  collision = 0;
+    std::uint16_t length    = 0;
+    if (!readRaw(in_, session_.seed) || !readRaw(in_, session_.ghosts)
+        || !readRaw(in_, collision) || !readRaw(in_, length)
+        || collision > std::uint8_t(CollisionMode::SpatialHash))
+        return false;
+    session_.collision = CollisionMode(collision);
+    session_.level.resize(length);
+    return bool(in_.read(session_.level.data(), length));
+}
+
+bool InputReplay::readVarint(std::uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = in_.get();
+        if (c == std::char_traits<char>::eof()) return false;
+        v |= std::uint64_t(c & 0x7F) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+bool InputReplay::next(Input& in)
+{
+    while (left_ == 0) {
+        if (done_) return false;
+        int c = in_.get();
+        if (c == std::char_traits<char>::eof()) { done_ = true; return false; }
+        if (std::uint8_t(c) == inputlog::END) {
+            done_ = true;
+            hasTrailer_ = readVarint(tick_) && readVarint(score_) && readRaw(in_, checksum_);
+            return false;
+        }
+        value_ = std::uint8_t(c);
+        if (!readVarint(left_)) { done_ = true; return false; }
+    }
+    --left_;
+    in = inputlog::unpack(value_);
+    return true;
+}
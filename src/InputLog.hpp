@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "Simulation.hpp"
+
+// binary per-tick input log.
+//
+//   "PMIL" | version u32 | session | runs... | end marker | trailer
+//   session: seed u64 | ghosts u32 | collision u8 | level length u16 | level
+//
+// The session is everything the Simulation was built from, so a replay
+// needs no flags to rebuild it.
+// Inputs are packed into one byte (direction | restart << 3) and stored as
+// runs: the byte followed by a LEB128 run length. Input rarely changes from
+// tick to tick, so a session costs a few bytes per key press. The trailer
+// holds the final tick, score and Simulation::checksum() so a replay can
+// prove it reproduced the session bit for bit.
+namespace inputlog {
+    inline constexpr std::uint32_t MAGIC   = 0x4C494D50;   // "PMIL"
+    inline constexpr std::uint32_t VERSION = 6;      // 2: checksum over fixed-point positions
+                                                     // 3: ghosts draw from the rng only at junctions
+                                                     // 4: four ghost behaviours
+                                                     // 5: level, ghosts and collision in the header
+                                                     // 6: checksum covers headings and flags
+    inline constexpr std::uint8_t  END     = 0xFF;
+
+    // what a recorded Simulation was built from
+    struct Session {
+        std::uint64_t seed{0};
+        std::string   level{"level1"};               // as given to Level::open
+        std::uint32_t ghosts{Simulation::GHOSTS};
+        CollisionMode collision{CollisionMode::BruteForce};
+
+        static Session of(const Simulation& sim, const std::string& level)
+        {
+            return {sim.seed(), level, std::uint32_t(sim.ghosts().size()), sim.collisionMode()};
+        }
+    };
+
+    inline std::uint8_t pack(const Input& in)  { return std::uint8_t(in.dir) | std::uint8_t(in.restart << 3); }
+    inline Input        unpack(std::uint8_t b) { return {Dir(b & 7), (b & 8) != 0}; }
+}
+
+class InputRecorder {
+public:
+    ~InputRecorder() { close(); }
+
+    bool open(const std::string& path, const inputlog::Session& session);
+    bool isOpen() const { return out_.is_open(); }
+
+    void record(const Input& in);
+    void finish(const Simulation& sim);    // writes the trailer and closes
+    void close();                          // closes without a trailer
+
+private:
+    void flushRun();
+    void writeVarint(std::uint64_t v);
+
+    std::ofstream out_;
+    std::uint8_t  value_{0};
+    std::uint64_t run_{0};
+};
+
+class InputReplay {
+public:
+    bool open(const std::string& path);
+
+    const inputlog::Session& session() const { return session_; }
+    std::uint64_t            seed()    const { return session_.seed; }
+    bool next(Input& in);                  // false once the log is exhausted
+
+    // valid after next() returned false, if the recording was finished
+    bool          hasTrailer()       const { return hasTrailer_; }
+    std::uint64_t expectedTick()     const { return tick_; }
+    std::uint64_t expectedScore()    const { return score_; }
+    std::uint64_t expectedChecksum() const { return checksum_; }
+
+private:
+    bool readVarint(std::uint64_t& v);
+
+    std::ifstream     in_;
+    inputlog::Session session_;
+    std::uint8_t  value_{0};
+    std::uint64_t left_{0};
+    bool          done_{false};
+
+    bool          hasTrailer_{false};
+    std::uint64_t tick_{0}, score_{0}, checksum_{0};
+};
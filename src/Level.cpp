@@ -1,95 +1,336 @@
 #include "Level.hpp"
+#include "Movement.hpp"
 #include <fstream>
+#include <sstream>
 #include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
 
-Level::Level(const std::string& txtFile, const sf::Texture& tileset)
-: tiles_(tileset)
+Level::Level(const std::string& txtFile)
 {
     std::ifstream in(txtFile);
+    load(in, txtFile);
+}
+
+Level Level::fromText(const std::string& text, const std::string& name)
+{
+    Level lvl;
+    std::istringstream in(text);
+    lvl.load(in, name);
+    return lvl;
+}
+
+void Level::load(std::istream& in, const std::string& name)
+{
+    std::vector<std::string> rows;
     std::string line;
-    while (std::getline(in, line))
-        grid_.push_back(line);
+    int ghostStarts = 0;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();     // CRLF files
+        // "; key value" lines are settings, not maze rows
+        if (!line.empty() && line[0] == ';') {
+            std::istringstream kv(line.substr(1));
+            std::string key;
+            kv >> key;
+            if (key == "ghosts" && !(kv >> ghostCount_))
+                throw std::runtime_error("bad ghosts setting in level " + name);
+            if (key == "player" && !(kv >> playerStart_.x >> playerStart_.y))
+                throw std::runtime_error("bad player setting in level " + name);
+            if (key == "ghost") {
+                Vec2i g;
+                if (ghostStarts == levelfmt::MAX_GHOST_STARTS || !(kv >> g.x >> g.y))
+                    throw std::runtime_error("bad ghost setting in level " + name);
+                ghostStarts_[std::size_t(ghostStarts++)] = g;
+            }
+            continue;
+        }
+        rows.push_back(line);
+    }
+    // the first row sets the width
+    if (rows.empty() || rows[0].empty())
+        throw std::runtime_error("cannot load level " + name);
+    for (int i = ghostStarts; ghostStarts > 0 && i < levelfmt::MAX_GHOST_STARTS; ++i)
+        ghostStarts_[std::size_t(i)] = ghostStarts_[std::size_t(i % ghostStarts)];
+
+    width_  = static_cast<int>(rows[0].size());
+    height_ = static_cast<int>(rows.size());
+    stride_ = width_ + 2;
+    for (auto& r : rows) r.resize(width_, ' ');
 
-    pellets_ = grid_;
+    const std::size_t words = (std::size_t(stride_) * (height_ + 2) + 63) / 64;
+    walls_.assign(words, 0);
+    pellets_.assign(words, 0);
+    teleportBits_.assign(words, 0);
 
-    for(int y=0;y<(int)grid_.size();++y){
-        int rowW = grid_[y].size()-1;
-        if(grid_[y][0] != '#' && grid_[y][rowW] != '#'){
+    for (int y=-1;y<=height_;++y)
+        for (int x=-1;x<=width_;++x) {
+            bool border = x<0 || y<0 || x>=width_ || y>=height_;
+            char c = border ? '#' : rows[y][x];
+            if (c == '#') set(walls_, bit(x,y));
+            if (c == '.') { set(pellets_, bit(x,y)); ++initialPelletCount_; }
+        }
+    initialPellets_ = pellets_;
+    pelletCount_    = initialPelletCount_;
+    eaten_.reserve(initialPelletCount_);
+
+    for(int y=0;y<height_;++y){
+        int rowW = width_-1;
+        if(rows[y][0] != '#' && rows[y][rowW] != '#'){
             teleports_.push_back({0,y});
             teleports_.push_back({rowW,y});
+            set(teleportBits_, bit(0,y));
+            set(teleportBits_, bit(rowW,y));
         }
     }
 
-    const int w = grid_[0].size();
-    const int h = grid_.size();
+    buildExits();
+    finishLoad(name);
+}
 
-    vertices_.setPrimitiveType(sf::PrimitiveType::Triangles);
-    vertices_.resize(w * h * 6);
+// a baked level's tables are already in this layout
+Level::Level(const levelfmt::LevelTables& t)
+: width_(t.width), height_(t.height), stride_(t.width + 2)
+, ghostCount_(t.ghostCount)
+, playerStart_(t.player)
+, walls_(t.walls.begin(), t.walls.end())
+, pellets_(t.pellets.begin(), t.pellets.end())
+, initialPellets_(t.pellets.begin(), t.pellets.end())
+, teleportBits_(t.teleportBits.begin(), t.teleportBits.end())
+, exits_(t.exits.begin(), t.exits.end())
+, pelletCount_(t.pelletCount)
+, initialPelletCount_(t.pelletCount)
+, teleports_(t.teleports.begin(), t.teleports.end())
+{
+    std::copy(t.ghosts.begin(), t.ghosts.end(), ghostStarts_.begin());
+    eaten_.reserve(initialPelletCount_);
+    finishLoad(std::string(t.name));
+}
 
-    for (int y = 0; y < h; ++y)
-        for (int x = 0; x < w; ++x)
-        {
-            if (grid_[y][x] != '#') continue;
-            sf::Vertex* v = &vertices_[(y * w + x) * 6];
+// what every level derives from its walls: the corridor graph and the
+// distance table, after checking the spawns
+void Level::finishLoad(const std::string& name)
+{
+    auto open = [&](Vec2i t) { return t.x>=0 && t.y>=0 && t.x<width_ && t.y<height_ && isWalkable(t.x,t.y); };
+    if (!open(playerStart_))
+        throw std::runtime_error("player starts in a wall in level " + name);
+    for (Vec2i g : ghostStarts_)
+        if (!open(g)) throw std::runtime_error("ghost starts in a wall in level " + name);
 
-            float L =  x      * TILE, R = (x + 1) * TILE;
-            float T =  y      * TILE, B = (y + 1) * TILE;
+    buildGraph();
+    findCorners();
+    buildDistanceTable();
+}
 
-            const sf::Vector2f tl{0,0}, tr{16,0}, bl{0,16}, br{16,16};
-            v[0].position={L,T}; v[0].texCoords=tl;
-            v[1].position={R,T}; v[1].texCoords=tr;
-            v[2].position={R,B}; v[2].texCoords=br;
-            v[3].position={L,T}; v[3].texCoords=tl;
-            v[4].position={R,B}; v[4].texCoords=br;
-            v[5].position={L,B}; v[5].texCoords=bl;
-        }
+// nearest by tile steps, then by row
+void Level::findCorners()
+{
+    for (int i = 0; i < 4; ++i) {
+        const int cx = i & 1 ? width_ - 1 : 0, cy = i & 2 ? height_ - 1 : 0;
+        const int sx = i & 1 ? -1 : 1,         sy = i & 2 ? -1 : 1;
+        corners_[std::size_t(i)] = {cx, cy};
+        for (int d = 0, found = 0; !found && d < width_ + height_; ++d)
+            for (int dy = 0; dy <= d; ++dy) {
+                const int x = cx + sx * (d - dy), y = cy + sy * dy;
+                if (x < 0 || y < 0 || x >= width_ || y >= height_ || !moves(x, y)) continue;
+                corners_[std::size_t(i)] = {x, y};
+                found = 1;
+                break;
+            }
+    }
 }
 
-bool Level::isWalkable(int gx,int gy) const
+void Level::buildExits()
 {
-    if (gy<0||gy>=height()||gx<0||gx>=width()) return false;
-    return grid_[gy][gx] != '#';
+    exits_.assign(std::size_t(stride_) * (height_ + 2), 0);
+    for (int y=-1;y<=height_;++y)
+        for (int x=-1;x<=width_;++x) {
+            if (!isWalkable(x,y)) continue;
+            std::uint8_t m = exitBit(Dir::None);
+            if (isWalkable(x-1,y)) m |= exitBit(Dir::Left);
+            if (isWalkable(x+1,y)) m |= exitBit(Dir::Right);
+            if (isWalkable(x,y-1)) m |= exitBit(Dir::Up);
+            if (isWalkable(x,y+1)) m |= exitBit(Dir::Down);
+            exits_[bit(x,y)] = m;
+        }
 }
 
-void Level::draw(sf::RenderTarget& rt) const
+void Level::buildGraph()
 {
-    rt.draw(vertices_, &tiles_);
-
-    sf::CircleShape dot(TILE * 0.15f);
-    dot.setOrigin({dot.getRadius(), dot.getRadius()});
-    dot.setFillColor({255,200,200});
-
-    for (int y=0;y<height();++y)
-        for (int x=0;x<width();++x)
-            if (pellets_[y][x] == '.')
-            {
-                dot.setPosition({TILE*(x+0.5f), TILE*(y+0.5f)});
-                rt.draw(dot);
+    constexpr Dir DIRS[4]{Dir::Left, Dir::Right, Dir::Up, Dir::Down};
+    moves_.assign(std::size_t(stride_) * (height_ + 2), 0);
+    std::size_t nodes = 0, maxCorridors = 0;
+    for (int y=0;y<height_;++y)
+        for (int x=0;x<width_;++x) {
+            const Fixed2 c = tileCenter({x,y});
+            if (!canOccupy(*this, c)) continue;
+            std::uint8_t m = 0;
+            for (Dir d : DIRS)
+                if (canMove(*this, c, d)) m |= exitBit(d);
+            moves_[bit(x,y)] = m;
+            if (isGraphNode(x,y)) { ++nodes; maxCorridors += std::popcount(unsigned(m)); }
+        }
+
+    // sized up front: on huge mazes the graph is the biggest part of a Level
+    graphNodes_.clear();
+    graphNodes_.reserve(nodes);
+    firstCorridor_.clear();
+    firstCorridor_.reserve(nodes + 1);
+    corridors_.clear();
+    corridors_.reserve(maxCorridors);
+    firstNodeOfRow_.assign(std::size_t(height_) + 1, 0);
+    for (int y=0;y<height_;++y) {
+        firstNodeOfRow_[y] = std::uint32_t(graphNodes_.size());
+        for (int x=0;x<width_;++x)
+            if (isGraphNode(x,y)) graphNodes_.push_back({x,y});
+    }
+    firstNodeOfRow_[height_] = std::uint32_t(graphNodes_.size());
+
+    auto step = [](Vec2i t, Dir d) {
+        Fixed2 s = dirStep(d);
+        return Vec2i{t.x + (s.x>0) - (s.x<0), t.y + (s.y>0) - (s.y<0)};
+    };
+    auto inside = [&](Vec2i t) { return t.x>=0 && t.y>=0 && t.x<width_ && t.y<height_; };
+
+    // walk every corridor out of every node; in between, each tile leaves
+    // exactly one way besides the one it was entered from
+    const int maxLen = width_ * height_;
+    for (const Vec2i from : graphNodes_) {
+        firstCorridor_.push_back(std::uint32_t(corridors_.size()));
+        for (Dir d : DIRS) {
+            if (!(moves(from.x,from.y) & exitBit(d))) continue;
+            Vec2i t = step(from, d);
+            if (!inside(t)) {
+                if (isTeleport(from.x,from.y)) {
+                    Vec2i to = teleportDestination(from.x,from.y);
+                    corridors_.push_back({graphNode(to.x,to.y), 1, d, d});
+                }
+                continue;
+            }
+            Dir dir = d;
+            int len = 1;
+            while (!isGraphNode(t.x,t.y) && len < maxLen) {
+                std::uint8_t out = moves(t.x,t.y) & ~exitBit(opposite(dir));
+                if (std::popcount(unsigned(out)) != 1) break;
+                dir = Dir(std::countr_zero(unsigned(out)));
+                t = step(t, dir);
+                ++len;
             }
+            if (!isGraphNode(t.x,t.y)) continue;      // a loop without nodes
+            corridors_.push_back({graphNode(t.x,t.y), std::uint32_t(len), d, dir});
+        }
+    }
+    firstCorridor_.push_back(std::uint32_t(corridors_.size()));
+}
+
+// nodes are in row order, so a binary search within the row finds one
+std::uint32_t Level::graphNode(int gx, int gy) const
+{
+    if (gy < 0 || gy >= height_) return NO_NODE;
+    auto first = graphNodes_.begin() + firstNodeOfRow_[gy];
+    auto last  = graphNodes_.begin() + firstNodeOfRow_[gy + 1];
+    auto it = std::lower_bound(first, last, gx, [](Vec2i a, int x) { return a.x < x; });
+    if (it == last || it->x != gx) return NO_NODE;
+    return std::uint32_t(it - graphNodes_.begin());
 }
 
-bool Level::pelletsRemaining() const
+void Level::buildDistanceTable()
 {
-    for (auto& row : pellets_)
-        for (char c : row)
-            if (c == '.') return true;
-    return false;
+    const int w = width(), h = height();
+    int walkable = 0;
+    for (int y=0;y<h;++y)
+        for (int x=0;x<w;++x)
+            walkable += isWalkable(x,y);
+    if (walkable > MAX_TABLE_NODES) {            // no per-tile index either
+        paths_.build(*this);
+        return;
+    }
+
+    node_.assign(std::size_t(w)*h, -1);
+    nodes_ = 0;
+    for (int y=0;y<h;++y)
+        for (int x=0;x<w;++x)
+            if (isWalkable(x,y)) node_[y*w+x] = nodes_++;
+
+    std::vector<Vec2i> tileOf(nodes_);
+    for (int y=0;y<h;++y)
+        for (int x=0;x<w;++x)
+            if (node_[y*w+x] >= 0) tileOf[node_[y*w+x]] = {x,y};
+
+    // one BFS per walkable tile, same 4-neighbourhood as the ghosts used
+    dist_.assign(std::size_t(nodes_)*nodes_, UNREACHABLE);
+    std::vector<int> queue(nodes_);
+    const int dx[4]={-1,1,0,0};
+    const int dy[4]={0,0,-1,1};
+    for (int src=0; src<nodes_; ++src) {
+        std::uint16_t* row = &dist_[std::size_t(src)*nodes_];
+        int head = 0, tail = 0;
+        row[src] = 0;
+        queue[tail++] = src;
+        while (head < tail) {
+            int c = queue[head++];
+            Vec2i t = tileOf[c];
+            for (int i=0;i<4;++i) {
+                int nx=t.x+dx[i], ny=t.y+dy[i];
+                if (!isWalkable(nx,ny)) continue;
+                int n = node_[ny*w+nx];
+                if (row[n] != UNREACHABLE) continue;
+                row[n] = std::uint16_t(row[c]+1);
+                queue[tail++] = n;
+            }
+        }
+    }
 }
 
 void Level::resetPellets()
 {
-    pellets_ = grid_;
+    std::memcpy(pellets_.data(), initialPellets_.data(), pellets_.size() * sizeof(std::uint64_t));
+    pelletCount_ = initialPelletCount_;
+    eaten_.clear();
+    ++epoch_;
+}
+
+// snapshot restore: the eaten log is rebuilt in bit order so renderers
+// resync through the usual epoch path. eaten_ keeps its capacity, so this
+// never allocates.
+void Level::restorePellets(const std::uint64_t* words)
+{
+    std::memcpy(pellets_.data(), words, pellets_.size() * sizeof(std::uint64_t));
+    pelletCount_ = 0;
+    eaten_.clear();
+    for (std::size_t i = 0; i < pellets_.size(); ++i) {
+        pelletCount_ += std::popcount(pellets_[i]);
+        for (std::uint64_t gone = initialPellets_[i] & ~pellets_[i]; gone; gone &= gone - 1)
+            eaten_.push_back(std::uint32_t(i * 64 + std::countr_zero(gone)));
+    }
+    ++epoch_;
+}
+
+void PelletBoard::reserve(const Level& lvl)
+{
+    bits.reserve(lvl.bitboardWords());
+    eaten.reserve(std::size_t(lvl.initialPelletCount()));
 }
 
-bool Level::isTeleport(int gx,int gy) const
+void PelletBoard::follow(const Level& lvl)
 {
-    return std::find(teleports_.begin(), teleports_.end(), sf::Vector2i{gx,gy}) != teleports_.end();
+    const auto& log = lvl.eatenSinceReset();
+    if (epoch == lvl.pelletEpoch() && eaten.size() <= log.size()) {
+        for (std::size_t k = eaten.size(); k < log.size(); ++k) {
+            bits[log[k] >> 6] &= ~(1ull << (log[k] & 63));
+            eaten.push_back(log[k]);
+        }
+        return;
+    }
+    bits.assign(lvl.pellets(), lvl.pellets() + lvl.bitboardWords());
+    eaten.assign(log.begin(), log.end());
+    epoch = lvl.pelletEpoch();
 }
 
-sf::Vector2f Level::teleportDestination(int gx,int gy) const
+Vec2i Level::teleportDestination(int gx,int gy) const
 {
     for(auto t: teleports_)
         if(t.y==gy && t.x!=gx)
-            return {TILE*(t.x+0.5f), TILE*(t.y+0.5f)};
-    return {TILE*(gx+0.5f), TILE*(gy+0.5f)};
+            return t;
+    return {gx,gy};
 }
@@ -1,37 +1,206 @@
 #pragma once
-#include <SFML/Graphics.hpp>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
 #include <vector>
 #include <string>
+#include <string_view>
 #include "Constants.hpp"
+#include "Geometry.hpp"
+#include "LevelFormat.hpp"
+#include "PathHierarchy.hpp"
 
+// maze rules only; drawing lives in LevelView.
+// Walls, pellets and teleports are bitboards over a grid padded with a one
+// tile wall border, so any tile in [-1,width] x [-1,height] can be probed
+// without a bounds check.
 class Level {
 public:
-    Level(const std::string& txtFile, const sf::Texture& tileset);
+    explicit Level(const std::string& txtFile);
+    static Level fromText(const std::string& text, const std::string& name = "<memory>");
 
-    bool isWalkable(int gx, int gy) const;
+    // levels baked in at build time from resources/levels (see LevelFormat.hpp):
+    // no file access and no parsing
+    static Level builtin(std::string_view name);
+    static bool  isBuiltin(std::string_view name);
+    static Level open(const std::string& nameOrFile);   // builtin if one has that name
+
+    // the tables cover [-1,width] x [-1,height]; every tile accessor below
+    // reads a tile outside that as a wall with nothing on it
+    bool inGrid(int gx, int gy) const
+    {
+        return (unsigned(gx + 1) < unsigned(stride_)) & (unsigned(gy + 1) < unsigned(height_ + 2));
+    }
+
+    bool isWalkable(int gx, int gy) const { return inGrid(gx,gy) && !test(walls_, bit(gx,gy)); }
+    bool isWall(int gx, int gy) const     { return !inGrid(gx,gy) || test(walls_, bit(gx,gy)); }
+
+    // per tile: exitBit(Dir::None) if the tile is walkable, plus exitBit(d)
+    // for every direction whose neighbour is walkable too
+    static constexpr std::uint8_t exitBit(Dir d) { return std::uint8_t(1u << int(d)); }
+    std::uint8_t exits(int gx, int gy) const { return inGrid(gx,gy) ? exits_[bit(gx,gy)] : 0; }
+
+    // per tile: exitBit(d) for every direction a body centred on the tile
+    // may start moving in (canMove from the centre), 0 where it cannot stand
+    std::uint8_t moves(int gx, int gy) const { return inGrid(gx,gy) ? moves_[bit(gx,gy)] : 0; }
+
+    // corridor graph, built at load: nodes are the tiles where a body has
+    // other than two ways to go (junctions and dead ends) plus the tunnel
+    // ends, in row order; edges are the corridors between them, corners
+    // included, stored per node. A tunnel end is linked to its pair by an
+    // edge of length 1.
+    struct Corridor {
+        std::uint32_t to;          // node index
+        std::uint32_t length;      // in tiles
+        Dir           leave;       // heading out of the node
+        Dir           arrive;      // heading on reaching `to`
+    };
+    static constexpr std::uint32_t NO_NODE = 0xFFFFFFFF;
+
+    bool isJunction(int gx, int gy) const { return std::popcount(unsigned(moves(gx,gy))) >= 3; }
+    bool isGraphNode(int gx, int gy) const
+    {
+        const unsigned m = moves(gx,gy);
+        return m && (std::popcount(m) != 2 || isTeleport(gx,gy));
+    }
+    std::uint32_t             graphNode(int gx, int gy) const;   // NO_NODE if not a node
+    const std::vector<Vec2i>& graphNodes() const { return graphNodes_; }
+    std::span<const Corridor> corridorsFrom(std::uint32_t node) const
+    {
+        return {corridors_.data() + firstCorridor_[node], corridors_.data() + firstCorridor_[node + 1]};
+    }
+    std::size_t               corridorCount() const { return corridors_.size(); }
 
     // pellet API
-    bool hasPellet(int gx,int gy) const { return pellets_[gy][gx] == '.'; }
-    void eatPellet(int gx,int gy)       { pellets_[gy][gx] = ' '; }
+    bool hasPellet(int gx,int gy) const { return inGrid(gx,gy) && test(pellets_, bit(gx,gy)); }
+    void eatPellet(int gx,int gy)
+    {
+        std::size_t    i = bit(gx,gy);
+        std::uint64_t& w = pellets_[i >> 6];
+        std::uint64_t  m = 1ull << (i & 63);
+        if (!(w & m)) return;
+        w &= ~m;
+        --pelletCount_;
+        eaten_.push_back(std::uint32_t(i));
+    }
 
-    bool pelletsRemaining() const;
+    bool pelletsRemaining() const { return pelletCount_ != 0; }
+    int  pelletCount()      const { return pelletCount_; }
     void resetPellets();
+    void restorePellets(const std::uint64_t* words);   // bitboardWords() words from pellets()
+
+    // raw pellet bitboard, for code that keeps its own copies per game
+    std::size_t          bitboardWords() const { return pellets_.size(); }
+    const std::uint64_t* pellets() const { return pellets_.data(); }
+    std::size_t          bit(int gx, int gy) const { return std::size_t(gy+1)*stride_ + (gx+1); }
+    Vec2i                tileOfBit(std::size_t i) const { return {int(i % stride_) - 1, int(i / stride_) - 1}; }
+    const std::uint64_t* initialPellets() const { return initialPellets_.data(); }
+    int                  initialPelletCount() const { return initialPelletCount_; }
+    bool                 initialPellet(int gx, int gy) const { return inGrid(gx,gy) && test(initialPellets_, bit(gx,gy)); }
+
+    // change log for renderers: bits eaten since the last reset, in order.
+    // It never holds more than the initial pellet count.
+    const std::vector<std::uint32_t>& eatenSinceReset() const { return eaten_; }
+    std::uint32_t                     pelletEpoch()     const { return epoch_; }   // bumped by resetPellets and restorePellets
 
     // teleport API
-    bool isTeleport(int gx,int gy) const;
-    sf::Vector2f teleportDestination(int gx,int gy) const;
+    bool isTeleport(int gx,int gy) const { return inGrid(gx,gy) && test(teleportBits_, bit(gx,gy)); }
+    Vec2i teleportDestination(int gx,int gy) const;   // the paired tunnel tile
+
+    // all-pairs tile distances, built at load for mazes up to MAX_TABLE_NODES
+    // walkable tiles (level1 has a few hundred, i.e. a few hundred KB)
+    static constexpr std::uint16_t UNREACHABLE     = 0xFFFF;
+    static constexpr int           MAX_TABLE_NODES = 4096;
+
+    bool hasDistanceTable() const { return !dist_.empty(); }
+    std::uint16_t distance(Vec2i a, Vec2i b) const
+    {
+        if (!hasDistanceTable()) return UNREACHABLE;
+        if (a.x<0||a.y<0||a.x>=width()||a.y>=height()) return UNREACHABLE;
+        if (b.x<0||b.y<0||b.x>=width()||b.y>=height()) return UNREACHABLE;
+        int ia = node_[a.y*width()+a.x], ib = node_[b.y*width()+b.x];
+        if (ia < 0 || ib < 0) return UNREACHABLE;
+        return dist_[std::size_t(ia)*nodes_ + ib];
+    }
 
-    void draw(sf::RenderTarget& rt) const;
-    int  width()  const { return static_cast<int>(grid_[0].size()); }
-    int  height() const { return static_cast<int>(grid_.size());    }
+    // for bigger mazes, the cluster hierarchy instead (empty when there is
+    // a table); its distances can be a few tiles long, never short
+    const PathHierarchy& paths() const { return paths_; }
+
+    int  width()  const { return width_;  }
+    int  height() const { return height_; }
+
+    // level settings, from "; key value" lines anywhere in the file
+    int   ghostCount() const { return ghostCount_; }   // 0 when the level leaves it to the game
+    Vec2i playerStart() const { return playerStart_; }
+    Vec2i ghostStart(int i) const { return ghostStarts_[std::size_t(i)]; }   // i < MAX_GHOST_STARTS
+
+    // the tile nearest each corner of the maze that a body can move from:
+    // 0 top-left, 1 top-right, 2 bottom-left, 3 bottom-right
+    Vec2i corner(int i) const { return corners_[std::size_t(i)]; }
 
 private:
-    std::vector<std::string> grid_;
-    std::vector<std::string> pellets_;
-    sf::VertexArray vertices_;
-    const sf::Texture& tiles_;
-    std::vector<sf::Vector2i> teleports_;
+    Level() = default;
+    explicit Level(const levelfmt::LevelTables& t);
+    void load(std::istream& in, const std::string& name);
+
+    static bool test(const std::vector<std::uint64_t>& b, std::size_t i)
+    {
+        return (b[i >> 6] >> (i & 63)) & 1u;
+    }
+    static void set(std::vector<std::uint64_t>& b, std::size_t i)
+    {
+        b[i >> 6] |= 1ull << (i & 63);
+    }
+
+    int width_{0}, height_{0}, stride_{0};
+    int ghostCount_{0};
+    Vec2i playerStart_{levelfmt::DEFAULT_PLAYER_START};
+    std::array<Vec2i, levelfmt::MAX_GHOST_STARTS> ghostStarts_{levelfmt::DEFAULT_GHOST_STARTS};
+
+    std::vector<std::uint64_t> walls_;
+    std::vector<std::uint64_t> pellets_;
+    std::vector<std::uint64_t> initialPellets_;
+    std::vector<std::uint64_t> teleportBits_;
+    std::vector<std::uint8_t>  exits_;      // padded grid, Level::bit layout
+    std::vector<std::uint8_t>  moves_;      // same layout
+    int pelletCount_{0};
+    int initialPelletCount_{0};
+    std::vector<std::uint32_t> eaten_;
+    std::uint32_t              epoch_{0};
+    std::vector<Vec2i> teleports_;
+
+    void finishLoad(const std::string& name);
+    void buildExits();
+    void buildGraph();
+    void findCorners();
+    std::array<Vec2i, 4>       corners_{};
+    std::vector<Vec2i>         graphNodes_;
+    std::vector<std::uint32_t> firstCorridor_;   // per node, plus one past the end
+    std::vector<std::uint32_t> firstNodeOfRow_;  // per row, plus one past the end
+    std::vector<Corridor>      corridors_;
+    void buildDistanceTable();
+    std::vector<int>           node_;    // tile -> walkable index, -1 for walls; with the table only
+    std::vector<std::uint16_t> dist_;    // nodes_ x nodes_
+    PathHierarchy              paths_;
+    int                        nodes_{0};
+};
+
+// a copy of a Level's pellets, e.g. in a snapshot handed to another thread.
+// Within one pellet epoch pellets only disappear, in eatenSinceReset()
+// order, so follow() replays the log entries the copy has not seen yet and
+// copies the whole board only when the epoch changed. With reserve() done,
+// following never allocates.
+struct PelletBoard {
+    static constexpr std::uint32_t NO_EPOCH = 0xFFFFFFFF;
 
-    static constexpr int TILE = 16;
+    std::vector<std::uint64_t> bits;      // Level::bit layout
+    std::vector<std::uint32_t> eaten;     // as Level::eatenSinceReset
+    std::uint32_t              epoch{NO_EPOCH};
 
+    bool has(std::size_t bit) const { return (bits[bit >> 6] >> (bit & 63)) & 1u; }
+    void reserve(const Level& lvl);
+    void follow(const Level& lvl);
 };
@@ -0,0 +1,212 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include "Geometry.hpp"
+
+// the level text format, and a constexpr parser that turns a level into
+// Level's tables at compile time.
+//
+//   #  wall        .  pellet        anything else  open floor
+//   (level1 marks its power pellet corners with P and the ghost door with G,
+//   neither of which the rules use yet)
+//   a row open at both ends is a tunnel between its two end tiles
+//   "; key value" lines anywhere set:  ghosts N   (how many ghosts)
+//                                      player X Y (player start tile)
+//                                      ghost X Y  (a ghost's start, up to four)
+//
+// Level::load reads the same format at runtime. Baked levels are stricter:
+// unknown characters or settings and rows longer than the first fail, and
+// since a throw is not a constant expression, they fail the build.
+namespace levelfmt {
+
+inline constexpr int   MAX_GHOST_STARTS = 4;
+inline constexpr Vec2i DEFAULT_PLAYER_START{12, 23};
+inline constexpr std::array<Vec2i, MAX_GHOST_STARTS> DEFAULT_GHOST_STARTS{{
+    {13, 14}, {14, 14}, {12, 14}, {15, 14}}};
+
+// a parsed level in Level's layout: bitboards and the exits table over the
+// grid padded with a wall border (see Level::bit)
+struct LevelTables {
+    std::string_view               name;
+    int                            width, height;
+    std::span<const std::uint64_t> walls, pellets, teleportBits;
+    std::span<const std::uint8_t>  exits;
+    std::span<const Vec2i>         teleports;
+    int                            pelletCount;
+    int                            ghostCount;
+    Vec2i                          player;
+    std::span<const Vec2i>         ghosts;
+};
+
+// calls f(line) for each line, split the way std::getline splits them;
+// a CRLF line ends before its '\r', as in Level::load
+template<class F>
+constexpr void forEachLine(std::string_view text, F f)
+{
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view line = text.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        f(line);
+        pos = end + 1;
+    }
+}
+
+constexpr bool isSetting(std::string_view line) { return !line.empty() && line[0] == ';'; }
+
+// next whitespace-separated word of s, consumed
+constexpr std::string_view nextWord(std::string_view& s)
+{
+    std::size_t b = 0;
+    while (b < s.size() && (s[b] == ' ' || s[b] == '\t')) ++b;
+    std::size_t e = b;
+    while (e < s.size() && s[e] != ' ' && s[e] != '\t') ++e;
+    std::string_view w = s.substr(b, e - b);
+    s.remove_prefix(e);
+    return w;
+}
+
+constexpr int parseCount(std::string_view word)
+{
+    if (word.empty() || word.size() > 6) throw std::runtime_error("bad number in level setting");
+    int v = 0;
+    for (char c : word) {
+        if (c < '0' || c > '9') throw std::runtime_error("bad number in level setting");
+        v = v * 10 + (c - '0');
+    }
+    return v;
+}
+
+struct Dims { int width{0}, height{0}; };
+
+constexpr Dims dims(std::string_view text)
+{
+    Dims d;
+    forEachLine(text, [&](std::string_view line) {
+        if (isSetting(line)) return;
+        if (d.height++ == 0) d.width = int(line.size());
+    });
+    if (d.height == 0 || d.width == 0) throw std::runtime_error("empty level");
+    return d;
+}
+
+template<int W, int H>
+struct Baked {
+    static constexpr int         STRIDE = W + 2;
+    static constexpr std::size_t CELLS  = std::size_t(STRIDE) * (H + 2);
+    static constexpr std::size_t WORDS  = (CELLS + 63) / 64;
+
+    std::string_view                     name;
+    std::array<std::uint64_t, WORDS>     walls{}, pellets{}, teleportBits{};
+    std::array<std::uint8_t, CELLS>      exits{};
+    std::array<Vec2i, 2 * H>             teleports{};
+    int                                  teleportCount{0};
+    int                                  pelletCount{0};
+    int                                  ghostCount{0};
+    Vec2i                                player{DEFAULT_PLAYER_START};
+    std::array<Vec2i, MAX_GHOST_STARTS>  ghosts{DEFAULT_GHOST_STARTS};
+
+    static constexpr std::size_t bit(int x, int y) { return std::size_t(y + 1) * STRIDE + (x + 1); }
+    static constexpr bool test(const std::array<std::uint64_t, WORDS>& b, std::size_t i)
+    {
+        return (b[i >> 6] >> (i & 63)) & 1u;
+    }
+    static constexpr void set(std::array<std::uint64_t, WORDS>& b, std::size_t i)
+    {
+        b[i >> 6] |= 1ull << (i & 63);
+    }
+    constexpr bool walkable(int x, int y) const { return !test(walls, bit(x, y)); }
+
+    constexpr LevelTables tables() const
+    {
+        return {name, W, H, walls, pellets, teleportBits, exits,
+                std::span<const Vec2i>(teleports.data(), std::size_t(teleportCount)),
+                pelletCount, ghostCount, player, ghosts};
+    }
+};
+
+// W x H must be dims(text)
+template<int W, int H>
+constexpr Baked<W, H> bake(std::string_view text, std::string_view name)
+{
+    using B = Baked<W, H>;
+    B lvl;
+    lvl.name = name;
+
+    // the border is wall, the inside floor until the rows say otherwise
+    for (int y = -1; y <= H; ++y)
+        for (int x = -1; x <= W; ++x)
+            if (x < 0 || y < 0 || x >= W || y >= H) B::set(lvl.walls, B::bit(x, y));
+
+    int y = 0, ghostStarts = 0;
+    std::array<bool, H> openEnds{};
+    auto spawn = [](std::string_view& rest) {
+        Vec2i t{parseCount(nextWord(rest)), parseCount(nextWord(rest))};
+        if (t.x >= W || t.y >= H) throw std::runtime_error("spawn outside the level");
+        return t;
+    };
+    forEachLine(text, [&](std::string_view line) {
+        if (isSetting(line)) {
+            std::string_view rest = line.substr(1);
+            std::string_view key  = nextWord(rest);
+            if (key == "ghosts")      lvl.ghostCount = parseCount(nextWord(rest));
+            else if (key == "player") lvl.player = spawn(rest);
+            else if (key == "ghost") {
+                if (ghostStarts == MAX_GHOST_STARTS) throw std::runtime_error("too many ghost starts");
+                lvl.ghosts[std::size_t(ghostStarts++)] = spawn(rest);
+            }
+            else throw std::runtime_error("unknown level setting");
+            if (!nextWord(rest).empty()) throw std::runtime_error("trailing words in level setting");
+            return;
+        }
+        if (int(line.size()) > W) throw std::runtime_error("level row longer than the first");
+        for (int x = 0; x < int(line.size()); ++x) {
+            const char c = line[std::size_t(x)];
+            if (c == '#') B::set(lvl.walls, B::bit(x, y));
+            else if (c == '.') { B::set(lvl.pellets, B::bit(x, y)); ++lvl.pelletCount; }
+            else if (c != ' ' && c != 'P' && c != 'G') throw std::runtime_error("unknown level character");
+        }
+        // short rows are padded with floor, like Level::load does
+        const bool firstOpen = line.empty() || line[0] != '#';
+        const bool lastOpen  = int(line.size()) < W || line[std::size_t(W - 1)] != '#';
+        openEnds[std::size_t(y)] = firstOpen && lastOpen;
+        ++y;
+    });
+
+    for (int r = 0; r < H; ++r)
+        if (openEnds[std::size_t(r)]) {
+            lvl.teleports[std::size_t(lvl.teleportCount++)] = {0, r};
+            lvl.teleports[std::size_t(lvl.teleportCount++)] = {W - 1, r};
+            B::set(lvl.teleportBits, B::bit(0, r));
+            B::set(lvl.teleportBits, B::bit(W - 1, r));
+        }
+
+    // Level::exitBit(d) is 1 << d
+    for (int ty = -1; ty <= H; ++ty)
+        for (int tx = -1; tx <= W; ++tx) {
+            if (!lvl.walkable(tx, ty)) continue;         // the border included
+            std::uint8_t m = 1u << int(Dir::None);
+            if (lvl.walkable(tx - 1, ty)) m |= 1u << int(Dir::Left);
+            if (lvl.walkable(tx + 1, ty)) m |= 1u << int(Dir::Right);
+            if (lvl.walkable(tx, ty - 1)) m |= 1u << int(Dir::Up);
+            if (lvl.walkable(tx, ty + 1)) m |= 1u << int(Dir::Down);
+            lvl.exits[B::bit(tx, ty)] = m;
+        }
+
+    // fewer than four ghost starts are shared round-robin
+    for (int i = ghostStarts; ghostStarts > 0 && i < MAX_GHOST_STARTS; ++i)
+        lvl.ghosts[std::size_t(i)] = lvl.ghosts[std::size_t(i % ghostStarts)];
+
+    if (!lvl.walkable(lvl.player.x, lvl.player.y)) throw std::runtime_error("player starts in a wall");
+    for (Vec2i g : lvl.ghosts)
+        if (!lvl.walkable(g.x, g.y)) throw std::runtime_error("ghost starts in a wall");
+    return lvl;
+}
+
+}
@@ -0,0 +1,162 @@
+#include "LevelView.hpp"
+#include <algorithm>
+#include <cmath>
+
+LevelView::LevelView(const Level& level, const sf::Texture& tileset)
+: level_(level)
+, tiles_(tileset)
+, chunksX_((level.width()  + CHUNK - 1) / CHUNK)
+, chunksY_((level.height() + CHUNK - 1) / CHUNK)
+, slotOfChunk_(std::size_t(chunksX_) * chunksY_, NONE)
+{
+    pool_.reserve(MAX_CHUNKS);
+}
+
+// the resident chunk (cx, cy), built into a free or the least recently
+// drawn pool entry when it is not
+LevelView::Chunk& LevelView::chunkAt(int cx, int cy, const PelletBoard& pellets)
+{
+    const int key = cy * chunksX_ + cx;
+    int& slot = slotOfChunk_[std::size_t(key)];
+    if (slot != NONE) return *pool_[std::size_t(slot)];
+
+    if (int(pool_.size()) < MAX_CHUNKS) {
+        slot = int(pool_.size());
+        pool_.push_back(std::make_unique<Chunk>());
+    } else {
+        auto lru = std::min_element(pool_.begin(), pool_.end(),
+            [](const auto& a, const auto& b) { return a->lastDrawn < b->lastDrawn; });
+        slotOfChunk_[std::size_t((*lru)->key)] = NONE;
+        slot = int(lru - pool_.begin());
+    }
+    Chunk& c = *pool_[std::size_t(slot)];
+    build(c, cx, cy, pellets);
+    c.key = key;
+    return c;
+}
+
+// walls and pellets of one chunk, pellets as the board has them right now
+void LevelView::build(Chunk& c, int cx, int cy, const PelletBoard& pellets)
+{
+    const int x0 = cx * CHUNK, x1 = std::min(x0 + CHUNK, level_.width());
+    const int y0 = cy * CHUNK, y1 = std::min(y0 + CHUNK, level_.height());
+
+    c.walls.setPrimitiveType(sf::PrimitiveType::Triangles);
+    c.walls.clear();
+    for (int y = y0; y < y1; ++y)
+        for (int x = x0; x < x1; ++x)
+        {
+            if (!level_.isWall(x, y)) continue;
+
+            float L =  x      * TILE, R = (x + 1) * TILE;
+            float T =  y      * TILE, B = (y + 1) * TILE;
+
+            const sf::Vector2f tl{0,0}, tr{16,0}, bl{0,16}, br{16,16};
+            c.walls.append(sf::Vertex{{L,T}, sf::Color::White, tl});
+            c.walls.append(sf::Vertex{{R,T}, sf::Color::White, tr});
+            c.walls.append(sf::Vertex{{R,B}, sf::Color::White, br});
+            c.walls.append(sf::Vertex{{L,T}, sf::Color::White, tl});
+            c.walls.append(sf::Vertex{{R,B}, sf::Color::White, br});
+            c.walls.append(sf::Vertex{{L,B}, sf::Color::White, bl});
+        }
+    c.wallsInBuffer = sf::VertexBuffer::isAvailable() && c.walls.getVertexCount()
+                   && c.wallBuffer.create(c.walls.getVertexCount())
+                   && c.wallBuffer.update(&c.walls[0]);
+
+    // one slot per pellet of the initial layout
+    c.slotOf.assign(CHUNK * CHUNK, NONE);
+    c.tileOfSlot.clear();
+    c.hidden.clear();
+    for (int y = y0; y < y1; ++y)
+        for (int x = x0; x < x1; ++x)
+            if (level_.initialPellet(x, y)) {
+                c.slotOf[(y - y0) * CHUNK + (x - x0)] = std::int16_t(c.tileOfSlot.size());
+                c.tileOfSlot.push_back({x, y});
+            }
+
+    c.hidden.reserve(c.tileOfSlot.size());      // so sync() never grows it
+    c.dots.setPrimitiveType(sf::PrimitiveType::Triangles);
+    c.dots.resize(c.tileOfSlot.size() * DOT_VERTS);
+    c.dotsInBuffer = false;
+    for (int s = 0; s < int(c.tileOfSlot.size()); ++s) {
+        const Vec2i t = c.tileOfSlot[s];
+        const bool visible = pellets.has(level_.bit(t.x, t.y));
+        setDot(c, s, visible);
+        if (!visible) c.hidden.push_back(s);
+    }
+    c.dotsInBuffer = sf::VertexBuffer::isAvailable() && !c.tileOfSlot.empty()
+                  && c.dotBuffer.create(c.dots.getVertexCount())
+                  && c.dotBuffer.update(&c.dots[0]);
+}
+
+// writes one pellet's octagon, or collapses it to a point when eaten
+void LevelView::setDot(Chunk& c, int slot, bool visible)
+{
+    const Vec2i t = c.tileOfSlot[slot];
+    const sf::Vector2f ctr{TILE*(t.x+0.5f), TILE*(t.y+0.5f)};
+    const float r = visible ? TILE * 0.15f : 0.f;
+
+    sf::Vertex* v = &c.dots[std::size_t(slot) * DOT_VERTS];
+    for (int i = 0; i < DOT_SEGS; ++i) {
+        float a0 = 2.f * PI * i / DOT_SEGS, a1 = 2.f * PI * (i + 1) / DOT_SEGS;
+        v[i*3+0].position = ctr;
+        v[i*3+1].position = {ctr.x + std::cos(a0) * r, ctr.y + std::sin(a0) * r};
+        v[i*3+2].position = {ctr.x + std::cos(a1) * r, ctr.y + std::sin(a1) * r};
+        for (int k = 0; k < 3; ++k) v[i*3+k].color = {255,200,200};
+    }
+
+    if (c.dotsInBuffer)
+        (void)c.dotBuffer.update(v, DOT_VERTS, unsigned(slot * DOT_VERTS));
+}
+
+// replays pellets eaten or restored since the last frame; chunks that are
+// not built pick the current state up from the bitboard when they are
+void LevelView::sync(const PelletBoard& pellets)
+{
+    if (pellets.epoch != epoch_) {
+        for (auto& c : pool_) {
+            for (int s : c->hidden) setDot(*c, s, true);
+            c->hidden.clear();
+        }
+        logPos_ = 0;
+        epoch_  = pellets.epoch;
+    }
+
+    const auto& log = pellets.eaten;
+    for (; logPos_ < log.size(); ++logPos_) {
+        const Vec2i t = level_.tileOfBit(log[logPos_]);
+        const int slot = slotOfChunk_[std::size_t(t.y / CHUNK * chunksX_ + t.x / CHUNK)];
+        if (slot == NONE) continue;
+        Chunk& c = *pool_[std::size_t(slot)];
+        const int s = c.slotOf[(t.y % CHUNK) * CHUNK + t.x % CHUNK];
+        if (s == NONE) continue;
+        setDot(c, s, false);
+        c.hidden.push_back(s);
+    }
+}
+
+void LevelView::draw(sf::RenderTarget& rt, const PelletBoard& pellets)
+{
+    sync(pellets);
+    ++frame_;
+
+    // chunks under the view, which may be larger than the maze
+    const sf::View& view = rt.getView();
+    const sf::Vector2f lo = view.getCenter() - view.getSize() / 2.f;
+    const sf::Vector2f hi = view.getCenter() + view.getSize() / 2.f;
+    const float span = float(CHUNK * TILE);
+    const int cx0 = std::max(0, int(std::floor(lo.x / span)));
+    const int cy0 = std::max(0, int(std::floor(lo.y / span)));
+    const int cx1 = std::min(chunksX_ - 1, int(std::floor(hi.x / span)));
+    const int cy1 = std::min(chunksY_ - 1, int(std::floor(hi.y / span)));
+
+    for (int cy = cy0; cy <= cy1; ++cy)
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            Chunk& c = chunkAt(cx, cy, pellets);
+            c.lastDrawn = frame_;
+            if (c.wallsInBuffer)               rt.draw(c.wallBuffer, &tiles_);
+            else if (c.walls.getVertexCount()) rt.draw(c.walls, &tiles_);
+            if (c.dotsInBuffer)                rt.draw(c.dotBuffer);
+            else if (c.dots.getVertexCount())  rt.draw(c.dots);
+        }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Level.hpp"
+
+// draws the walls of a Level and the pellets of a PelletBoard following
+// it, which may be a snapshot's copy owned by another thread than the
+// level's.
+// The maze is cut into CHUNK x CHUNK tile chunks with their own wall and
+// pellet vertex buffers. A frame draws only the chunks that intersect the
+// target's view; a chunk is built when it first comes into view and the
+// least recently drawn one is recycled beyond MAX_CHUNKS, so frame time and
+// memory follow the window, not the maze. Inside a chunk every pellet of the
+// initial layout owns a fixed slot of vertices; eaten pellets are collapsed
+// and restored in place by replaying the level's change log.
+class LevelView {
+public:
+    static constexpr int CHUNK      = 16;            // tiles per side
+    static constexpr int MAX_CHUNKS = 64;            // built at once
+
+    LevelView(const Level& level, const sf::Texture& tileset);
+
+    void draw(sf::RenderTarget& rt, const PelletBoard& pellets);
+    int  residentChunks() const { return int(pool_.size()); }
+
+private:
+    static constexpr int DOT_SEGS  = 8;              // octagon per pellet
+    static constexpr int DOT_VERTS = DOT_SEGS * 3;
+    static constexpr int NONE      = -1;
+
+    struct Chunk {
+        int               key{NONE};                 // cy * chunksX_ + cx
+        std::uint64_t     lastDrawn{0};
+        sf::VertexArray   walls;
+        sf::VertexBuffer  wallBuffer{sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Static};
+        bool              wallsInBuffer{false};
+        sf::VertexArray   dots;                      // CPU copy, also the fallback
+        sf::VertexBuffer  dotBuffer{sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Dynamic};
+        bool              dotsInBuffer{false};
+        std::vector<std::int16_t> slotOf;            // local tile -> dot slot, NONE if none
+        std::vector<Vec2i>        tileOfSlot;
+        std::vector<int>          hidden;            // slots collapsed this epoch
+    };
+
+    Chunk& chunkAt(int cx, int cy, const PelletBoard& pellets);
+    void   build(Chunk& c, int cx, int cy, const PelletBoard& pellets);
+    void   sync(const PelletBoard& pellets);
+    void   setDot(Chunk& c, int slot, bool visible);
+
+    const Level&       level_;
+    const sf::Texture& tiles_;
+    int                chunksX_, chunksY_;
+    std::vector<int>   slotOfChunk_;                 // key -> index in pool_, NONE if not built
+    std::vector<std::unique_ptr<Chunk>> pool_;
+    std::uint64_t      frame_{0};
+
+    std::uint32_t epoch_{PelletBoard::NO_EPOCH};
+    std::size_t   logPos_{0};
+};
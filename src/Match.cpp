@@ -0,0 +1,152 @@
+#include "Match.hpp"
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+Match::Match(Level level, std::uint64_t seed, int ghosts)
+: level_(std::move(level))
+, rng_{seed}
+{
+    if (ghosts <= 0) ghosts = level_.ghostCount();
+    if (ghosts <= 0) ghosts = Simulation::GHOSTS;
+    if (ghosts > MAX_GHOSTS) throw std::runtime_error("too many ghosts for a match");
+
+    // pac-men share the player start; ghosts take the level's starts in turn
+    slots_.reserve(std::size_t(MAX_PACMEN + ghosts));
+    for (int i = 0; i < MAX_PACMEN; ++i)
+        slots_.emplace_back(Role::PacMan, tileCenter(level_.playerStart()), 0xFFFF00FFu);
+    for (int i = 0; i < ghosts; ++i)
+        slots_.emplace_back(Role::Ghost, tileCenter(level_.ghostStart(i % levelfmt::MAX_GHOST_STARTS)),
+                            Simulation::GHOST_COLOR[i % Simulation::GHOSTS]);
+}
+
+int Match::join(Role r)
+{
+    for (int i = 0; i < slots(); ++i) {
+        Slot& s = slots_[std::size_t(i)];
+        if (s.role != r || s.taken) continue;
+        s.taken = true;
+        if (r == Role::PacMan) {
+            s.body.reset();
+            s.lives = Simulation::START_LIVES;
+            s.out   = gameOver_;               // a finished game is joined at the restart
+            s.grace = SPAWN_GRACE;
+        } else {
+            const Ghost::State g = s.ai.save();
+            s.body.restore({g.pos, 0.f, g.curDir, g.curDir, g.curDir, g.onTeleport});
+        }
+        return i;
+    }
+    return -1;
+}
+
+void Match::leave(int slot)
+{
+    Slot& s = slots_[std::size_t(slot)];
+    if (!s.taken) return;
+    s.taken = false;
+    s.score = 0;
+    if (s.role == Role::Ghost) {
+        // the AI carries on where the player left off, never standing still
+        const Player::State b = s.body.save();
+        s.ai.restore({b.pos, b.curDir != Dir::None ? b.curDir : b.lastDir, b.onTeleport});
+    }
+}
+
+void Match::restart()
+{
+    level_.resetPellets();
+    for (Slot& s : slots_) {
+        s.body.reset();
+        s.ai.reset();
+        s.score = 0;
+        s.out   = false;
+        s.lives = Simulation::START_LIVES;
+        s.grace = SPAWN_GRACE;
+    }
+    levelCleared_ = false;
+    gameOver_     = false;
+}
+
+void Match::respawn(Slot& s)
+{
+    s.body.reset();
+    s.grace = SPAWN_GRACE;
+}
+
+ghostai::Hunt Match::huntFor(Fixed2 ghost) const
+{
+    const Slot* best = nullptr;
+    std::int64_t bestD = 0;
+    for (int i = 0; i < MAX_PACMEN; ++i) {
+        const Slot& s = slots_[std::size_t(i)];
+        if (!s.taken || s.out) continue;
+        const Fixed2 p = s.body.position();
+        const std::int64_t d = std::abs(std::int64_t(p.x) - ghost.x) + std::abs(std::int64_t(p.y) - ghost.y);
+        if (!best || d < bestD) { best = &s; bestD = d; }
+    }
+    if (!best) return {tileOf(ghost), Dir::None};
+    return {tileOf(best->body.position()), best->body.facing()};
+}
+
+unsigned Match::step(const Input* inputs)
+{
+    ++tick_;
+    if (finished()) {
+        for (int i = 0; i < slots(); ++i)
+            if (slots_[std::size_t(i)].taken && inputs[i].restart) {
+                restart();
+                return EV_RESTART;
+            }
+        return EV_NONE;
+    }
+
+    unsigned ev = EV_NONE;
+    for (int i = 0; i < slots(); ++i) {
+        Slot& s = slots_[std::size_t(i)];
+        if (s.role == Role::PacMan) {
+            if (!s.taken || s.out) continue;
+            s.body.setInput(inputs[i].dir);
+            if (s.body.update(level_)) {
+                s.score += Simulation::PELLET_SCORE;
+                ev |= EV_PELLET;
+            }
+            if (s.grace > 0) --s.grace;
+        } else if (s.taken) {
+            s.body.setInput(inputs[i].dir);
+            s.body.move(level_);
+        } else {
+            const ghostai::Hunt hunt = huntFor(s.ai.position());
+            ghostai::withPolicy(ghostai::kindOf(std::size_t(i - MAX_PACMEN)), [&]<class Policy>(Policy) {
+                s.ai.update<Policy>(level_, hunt, rng_);
+            });
+        }
+    }
+
+    // every pac-man against every ghost; a player's ghost scores the catch
+    bool anyIn = false, anyTaken = false;
+    for (int i = 0; i < MAX_PACMEN; ++i) {
+        Slot& p = slots_[std::size_t(i)];
+        if (!p.taken) continue;
+        anyTaken = true;
+        if (p.out) continue;
+        for (int g = MAX_PACMEN; g < slots() && p.grace == 0 && !p.out; ++g) {
+            Slot& ghost = slots_[std::size_t(g)];
+            if (!touching(ghost.position(), p.body.position())) continue;
+            if (ghost.taken) ghost.score += CATCH_SCORE;
+            ev |= EV_DEATH;
+            if (--p.lives <= 0) p.out = true;
+            else                respawn(p);
+        }
+        anyIn |= !p.out;
+    }
+    if (anyTaken && !anyIn) {
+        gameOver_ = true;
+        ev |= EV_GAME_OVER;
+    }
+    if (!level_.pelletsRemaining()) {
+        levelCleared_ = true;
+        ev |= EV_LEVEL_CLEAR;
+    }
+    return ev;
+}
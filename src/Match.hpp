@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Ghost.hpp"
+#include "Level.hpp"
+#include "Player.hpp"
+#include "Random.hpp"
+#include "Simulation.hpp"
+
+// game rules for several players in one level: up to MAX_PACMEN pac-men
+// that eat and score on their own, and ghosts that the AI runs unless a
+// player has taken one over. Bodies move with the single-player code
+// (Player for anything steered by input, Ghost for the AI), so a client
+// predicting its own body reproduces the server bit for bit.
+//
+// Slots are fixed: [0, MAX_PACMEN) are pac-men, then one per ghost. Like
+// Simulation, a match is a pure function of the seed and the inputs.
+class Match {
+public:
+    enum class Role : std::uint8_t { PacMan, Ghost };
+
+    static constexpr int      MAX_PACMEN  = 4;
+    static constexpr int      MAX_GHOSTS  = 8;
+    static constexpr int      MAX_SLOTS   = MAX_PACMEN + MAX_GHOSTS;
+    static constexpr unsigned CATCH_SCORE = 200;                     // a player's ghost catching a pac-man
+    static constexpr int      SPAWN_GRACE = Simulation::TICK_HZ * 2; // ticks a respawned pac-man cannot be caught
+
+    struct Slot {
+        Slot(Role r, Fixed2 start, std::uint32_t color) : role(r), body(start), ai(color, start) {}
+
+        Role          role;
+        bool          taken{false};     // a player's; untaken pac-men are not in play
+        bool          out{false};       // a pac-man with no lives left
+        Player        body;             // pac-men and player-run ghosts
+        Ghost         ai;               // AI ghosts
+        std::int32_t  lives{0};
+        std::uint32_t score{0};
+        std::int32_t  grace{0};
+
+        bool   aiRun()    const { return role == Role::Ghost && !taken; }
+        Fixed2 position() const { return aiRun() ? ai.position() : body.position(); }
+        Dir    heading()  const { return aiRun() ? ai.save().curDir : body.save().curDir; }
+        Dir    facing()   const { return aiRun() ? ai.save().curDir : body.facing(); }   // an AI ghost faces its way
+    };
+
+    // ghosts == 0 takes the level's setting, else Simulation::GHOSTS
+    explicit Match(Level level, std::uint64_t seed = 0, int ghosts = 0);
+
+    // a free slot of that role for a new player, -1 when there is none;
+    // a ghost is taken over where it stands
+    int  join(Role r);
+    void leave(int slot);
+
+    // one tick; inputs[s] for every slot, ignored where no player steers.
+    // Returns SimEvent bits; EV_RESTART once any player asks for a new
+    // game after the last one ended.
+    unsigned step(const Input* inputs);
+
+    int           slots()  const { return int(slots_.size()); }
+    const Slot&   slot(int s) const { return slots_[std::size_t(s)]; }
+    const Level&  level()  const { return level_; }
+    std::uint64_t tick()   const { return tick_; }
+    bool finished()     const { return levelCleared_ || gameOver_; }
+    bool levelCleared() const { return levelCleared_; }
+    bool gameOver()     const { return gameOver_; }
+
+private:
+    void restart();
+    void respawn(Slot& s);
+    ghostai::Hunt huntFor(Fixed2 ghost) const;    // the nearest pac-man in play
+
+    Level                           level_;
+    std::vector<Slot>               slots_;       // pac-men first, then ghosts
+    SplitMix64                      rng_;
+    std::uint64_t                   tick_{0};
+    bool                            gameOver_{false};
+    bool                            levelCleared_{false};
+};
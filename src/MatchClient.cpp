@@ -0,0 +1,165 @@
+#include "MatchClient.hpp"
+#include "InputLog.hpp"
+#include "Movement.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+MatchClient::MatchClient(Level level, Match::Role role)
+: level_(std::move(level))
+, role_(role)
+, levelHash_(net::levelHash(level_))
+, body_(tileCenter(level_.playerStart()))
+{
+}
+
+void MatchClient::connect(std::uint32_t ip, const NetAddress& server)
+{
+    socket_.open(ip, 0);
+    server_    = server;
+    helloSent_ = false;
+    slot_      = -1;
+    refused_   = false;
+    synced_    = false;
+    seq_       = 0;
+}
+
+void MatchClient::disconnect(std::uint64_t nowMs)
+{
+    if (!joined()) return;
+    const std::uint8_t bye = net::BYE;
+    socket_.send(server_, &bye, 1, nowMs);
+    socket_.flush(nowMs);
+    slot_ = -1;
+}
+
+bool MatchClient::predicting() const
+{
+    if (!synced_ || latest_.flags) return false;
+    const NetState::Slot& me = latest_.slots[std::size_t(slot_)];
+    return (me.flags & NetState::TAKEN) && !(me.flags & NetState::OUT);
+}
+
+void MatchClient::tick(const Input& in, std::uint64_t nowMs)
+{
+    std::uint8_t buf[32];
+    net::Writer w(buf, sizeof buf);
+
+    if (!joined()) {
+        if (!refused_ && (!helloSent_ || nowMs - helloMs_ >= HELLO_EVERY_MS)) {
+            w.u8(net::HELLO);
+            w.u32(net::MAGIC);
+            w.u8(net::VERSION);
+            w.u8(std::uint8_t(role_));
+            socket_.send(server_, buf, w.size(), nowMs);
+            helloSent_ = true;
+            helloMs_   = nowMs;
+        }
+        socket_.flush(nowMs);
+        return;
+    }
+
+    ++seq_;
+    inputs_[seq_ % INPUT_RING] = in;
+    const std::uint8_t packed = inputlog::pack(in);
+    std::uint32_t repeats = 0;
+    while (repeats + 1 < net::INPUT_REDUNDANCY && repeats + 1 < seq_
+           && inputlog::pack(inputs_[(seq_ - repeats - 1) % INPUT_RING]) == packed)
+        ++repeats;
+    w.u8(net::INPUT);
+    w.u8(std::uint8_t(seq_));
+    w.u8(std::uint8_t(latest_.tick));
+    w.u8(std::uint8_t(packed | repeats << 4 | (synced_ ? net::INPUT_ACKING : 0)));
+    socket_.send(server_, buf, w.size(), nowMs);
+
+    if (predicting()) predict(seq_);
+    else              predictedAt_[seq_ % INPUT_RING] = body_.position();
+    socket_.flush(nowMs);
+}
+
+void MatchClient::predict(std::uint32_t seq)
+{
+    body_.setInput(inputs_[seq % INPUT_RING].dir);
+    if (role_ == Match::Role::PacMan) body_.update(level_);
+    else                              body_.move(level_);
+    predictedAt_[seq % INPUT_RING] = body_.position();
+}
+
+void MatchClient::poll(std::uint64_t nowMs)
+{
+    std::uint8_t buf[net::MAX_DATAGRAM];
+    NetAddress from;
+    std::size_t n;
+    while (socket_.receive(from, buf, sizeof buf, n))
+        if (from == server_) {
+            bytesIn_ += n;
+            handle(buf, n);
+        }
+    socket_.flush(nowMs);
+}
+
+void MatchClient::handle(const std::uint8_t* data, std::size_t n)
+{
+    net::Reader r(data, n);
+    const std::uint8_t type = r.u8();
+    if (type == net::FULL && !joined()) {
+        refused_ = true;
+    } else if (type == net::WELCOME && !joined()) {
+        const std::uint8_t  slot  = r.u8();
+        const std::uint8_t  slots = r.u8();
+        const std::uint32_t hash  = r.u32();
+        if (!r.ok() || slot >= slots) return;
+        if (hash != levelHash_) throw std::runtime_error("the server plays a different level");
+        slot_ = slot;
+        blank_.blank(slots, level_.bitboardWords());
+        history_.assign(net::HISTORY, blank_);
+        latest_ = scratch_ = guess_ = blank_;
+    } else if ((type & ~net::AGE_MASK) == net::SNAPSHOT && joined()) {
+        onSnapshot(type & net::AGE_MASK, r);
+    }
+}
+
+void MatchClient::onSnapshot(int age, net::Reader& r)
+{
+    const std::uint32_t tick = age ? net::unwrap8(latest_.tick, r.u8()) : std::uint32_t(r.var());
+    if (!r.ok()) return;
+    if (synced_ && tick <= latest_.tick) { ++stale_; return; }
+
+    const NetState* base = &blank_;
+    std::uint32_t inputAck = 0;
+    if (age > 0) {
+        const std::uint32_t from = tick - std::uint32_t(age);
+        base = &history_[from % net::HISTORY];
+        if (!synced_ || base->tick != from) { ++undecodable_; return; }
+        inputAck = acks_[from % net::HISTORY] + std::uint32_t(age);
+    }
+    std::int64_t ackOff = 0;
+    if (!net::decodeDelta(level_, *base, age, r, guess_, scratch_, ackOff)) { ++undecodable_; return; }
+    inputAck = std::uint32_t(inputAck + ackOff);
+    scratch_.tick = tick;
+    acks_[tick % net::HISTORY] = inputAck;
+    std::swap(scratch_, history_[tick % net::HISTORY]);
+    latest_  = history_[tick % net::HISTORY];
+    synced_  = true;
+    ++snapshots_;
+    reconcile(inputAck);
+}
+
+void MatchClient::reconcile(std::uint32_t inputAck)
+{
+    const NetState::Slot& me = latest_.slots[std::size_t(slot_)];
+    if (role_ == Match::Role::PacMan) level_.restorePellets(latest_.pellets.data());
+
+    const bool replay = predicting() && inputAck <= seq_ && seq_ - inputAck < INPUT_RING;
+    if (replay && inputAck > 0 && predictedAt_[inputAck % INPUT_RING] != me.pos) ++corrections_;
+
+    // the turn the server has queued is the last one asked for by then
+    Dir next = Dir::None;
+    for (std::uint32_t s = inputAck; s > 0 && inputAck - s < INPUT_RING && next == Dir::None; --s)
+        next = inputs_[s % INPUT_RING].dir;
+    const Vec2i t = tileOf(me.pos);
+    body_.restore({me.pos, body_.mouthPhase(), me.heading, next, me.facing, level_.isTeleport(t.x, t.y)});
+
+    if (replay)
+        for (std::uint32_t s = inputAck + 1; s <= seq_; ++s) predict(s);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Level.hpp"
+#include "Match.hpp"
+#include "NetCodec.hpp"
+#include "Player.hpp"
+#include "UdpSocket.hpp"
+
+// a player's end of a MatchServer session. Every tick() sends the input
+// (with how many ticks before held it, against loss) and moves the
+// player's own body at once with Player's movement code, ahead of the server. Each snapshot
+// puts the body back where the server had it after the last input it
+// applied and replays the inputs sent since, so a correct prediction is
+// invisible and a wrong one is fixed within a round trip.
+class MatchClient {
+public:
+    static constexpr int HELLO_EVERY_MS = 250;
+    static constexpr int INPUT_RING     = 128;    // inputs kept for replay, by sequence
+
+    MatchClient(Level level, Match::Role role);
+
+    UdpSocket& socket() { return socket_; }
+
+    // binds a local port on ip and starts saying hello to server
+    void connect(std::uint32_t ip, const NetAddress& server);
+    void disconnect(std::uint64_t nowMs);
+
+    void poll(std::uint64_t nowMs);                  // snapshots in; throws if the level differs
+    void tick(const Input& in, std::uint64_t nowMs); // one local tick
+
+    bool joined()  const { return slot_ >= 0; }
+    bool refused() const { return refused_; }       // the server had no free slot
+    int  slot()    const { return slot_; }
+
+    // the newest server state, with the own body where prediction has it
+    const NetState& latest() const { return latest_; }
+    Fixed2          predicted() const { return body_.position(); }
+    bool            predicting() const;
+
+    // for reports
+    std::uint64_t snapshots()     const { return snapshots_; }
+    std::uint64_t undecodable()   const { return undecodable_; }   // baseline already gone
+    std::uint64_t stale()         const { return stale_; }         // older than one already seen
+    std::uint64_t corrections()   const { return corrections_; }   // predictions the server disagreed with
+    std::uint64_t bytesIn()       const { return bytesIn_; }
+    std::uint64_t bytesOut()      const { return socket_.bytesSent(); }
+
+private:
+    void handle(const std::uint8_t* data, std::size_t n);
+    void onSnapshot(int age, net::Reader& r);
+    void reconcile(std::uint32_t inputAck);
+    void predict(std::uint32_t seq);
+
+    Level                         level_;         // pellets as predicted
+    Match::Role                   role_;
+    std::uint32_t                 levelHash_;
+    UdpSocket                     socket_;
+    NetAddress                    server_;
+    std::uint64_t                 helloMs_{0};
+    bool                          helloSent_{false};
+    int                           slot_{-1};
+    bool                          refused_{false};
+
+    std::vector<NetState>         history_;       // decoded snapshots by tick % net::HISTORY
+    std::array<std::uint32_t, net::HISTORY> acks_{};   // their input acks
+    NetState                      latest_, scratch_, guess_, blank_;
+    bool                          synced_{false}; // a snapshot arrived
+
+    Player                        body_;
+    std::uint32_t                 seq_{0};        // last input sent
+    std::array<Input, INPUT_RING>  inputs_{};
+    std::array<Fixed2, INPUT_RING> predictedAt_{}; // body after each input
+
+    std::uint64_t snapshots_{0}, undecodable_{0}, stale_{0}, corrections_{0}, bytesIn_{0};
+};
@@ -0,0 +1,186 @@
+#include "MatchServer.hpp"
+#include "InputLog.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+// bytes of a snapshot besides the pellet words, at worst: the header, and
+// every field of every slot at full width after a head full of turns
+static constexpr std::size_t SNAPSHOT_OVERHEAD = 16 + Match::MAX_SLOTS * 40;
+
+MatchServer::MatchServer(Match match, std::uint32_t ip, std::uint16_t port)
+: match_(std::move(match))
+, levelHash_(net::levelHash(match_.level()))
+{
+    const std::size_t words = match_.level().bitboardWords();
+    if (SNAPSHOT_OVERHEAD + words * 8 > net::MAX_DATAGRAM)
+        throw std::runtime_error("level too large to send in one datagram");
+
+    socket_.open(ip, port);
+    blank_.blank(std::size_t(match_.slots()), words);
+    history_.assign(net::HISTORY, blank_);
+    history_[0].capture(match_);
+    inputs_.resize(std::size_t(match_.slots()));
+}
+
+const NetState* MatchServer::history(std::uint32_t t) const
+{
+    const NetState& s = history_[t % net::HISTORY];
+    return s.tick == t && t <= match_.tick() ? &s : nullptr;
+}
+
+std::vector<MatchServer::Stats> MatchServer::stats() const
+{
+    std::vector<Stats> v;
+    for (const Client& c : clients_) v.push_back(c.stats);
+    return v;
+}
+
+void MatchServer::poll(std::uint64_t nowMs)
+{
+    std::uint8_t buf[net::MAX_DATAGRAM];
+    NetAddress from;
+    std::size_t n;
+    while (socket_.receive(from, buf, sizeof buf, n)) handle(from, buf, n, nowMs);
+
+    for (std::size_t i = 0; i < clients_.size();) {
+        if (nowMs - clients_[i].heardMs > TIMEOUT_MS) {
+            match_.leave(clients_[i].slot);
+            clients_.erase(clients_.begin() + std::ptrdiff_t(i));
+        } else ++i;
+    }
+}
+
+void MatchServer::send(Client& c, net::Writer& w, const std::uint8_t* buf, std::uint64_t nowMs)
+{
+    if (w.overflow()) throw std::runtime_error("message larger than net::MAX_DATAGRAM");
+    socket_.send(c.addr, buf, w.size(), nowMs);
+    c.stats.bytesOut += w.size();
+    ++c.stats.datagramsOut;
+}
+
+void MatchServer::handle(const NetAddress& from, const std::uint8_t* data, std::size_t n, std::uint64_t nowMs)
+{
+    net::Reader r(data, n);
+    const std::uint8_t type = r.u8();
+    auto it = std::find_if(clients_.begin(), clients_.end(), [&](const Client& c) { return c.addr == from; });
+
+    if (type == net::HELLO) {
+        const std::uint32_t magic   = r.u32();
+        const std::uint8_t  version = r.u8();
+        const std::uint8_t  role    = r.u8();
+        if (!r.ok() || magic != net::MAGIC || version != net::VERSION || role > std::uint8_t(Match::Role::Ghost))
+            return;
+
+        std::uint8_t buf[32];
+        net::Writer w(buf, sizeof buf);
+        if (it == clients_.end()) {
+            const int slot = match_.join(Match::Role(role));
+            if (slot < 0) {
+                w.u8(net::FULL);
+                socket_.send(from, buf, w.size(), nowMs);
+                return;
+            }
+            Client c;
+            c.addr = from;
+            c.slot = slot;
+            c.stats.addr = from;
+            c.stats.slot = slot;
+            clients_.push_back(c);
+            it = clients_.end() - 1;
+        }
+        // a repeated HELLO means the WELCOME was lost
+        w.u8(net::WELCOME);
+        w.u8(std::uint8_t(it->slot));
+        w.u8(std::uint8_t(match_.slots()));
+        w.u32(levelHash_);
+        it->heardMs = nowMs;
+        it->stats.bytesIn += n;
+        ++it->stats.datagramsIn;
+        send(*it, w, buf, nowMs);
+        return;
+    }
+    if (it == clients_.end()) return;
+    Client& c = *it;
+    c.heardMs = nowMs;
+    c.stats.bytesIn += n;
+    ++c.stats.datagramsIn;
+
+    if (type == net::BYE) {
+        match_.leave(c.slot);
+        clients_.erase(it);
+        return;
+    }
+    if (type != net::INPUT) return;
+
+    const std::uint32_t tick = std::uint32_t(match_.tick());
+    const std::uint32_t seq  = net::unwrap8(c.newestSeq, r.u8());
+    const std::uint8_t  ack  = r.u8();
+    const std::uint8_t  in   = r.u8();
+    if (!r.ok()) return;
+    if (in & net::INPUT_ACKING) {
+        const std::uint32_t acked = net::unwrap8(tick, ack);
+        if (acked > c.acked && acked <= tick) c.acked = acked;
+    }
+    const int count = 1 + (in >> 4 & 7);
+    for (int k = 0; k < count && std::uint32_t(k) < seq; ++k) {
+        const std::uint32_t s = seq - std::uint32_t(k);
+        if (s <= c.appliedSeq) break;
+        c.input[s % INPUT_RING]    = in & 15;
+        c.inputSeq[s % INPUT_RING] = s;
+    }
+    c.newestSeq = std::max(c.newestSeq, seq);
+}
+
+// one input per tick, in sequence. A missing one reuses the last; a
+// backlog past MAX_INPUT_LAG, left by late inputs, is skipped over
+Input MatchServer::nextInput(Client& c)
+{
+    if (c.newestSeq > c.appliedSeq + MAX_INPUT_LAG) c.appliedSeq = c.newestSeq - MAX_INPUT_LAG;
+    const std::uint32_t want = c.appliedSeq + 1;
+    if (want <= c.newestSeq && c.inputSeq[want % INPUT_RING] == want) {
+        c.last = inputlog::unpack(c.input[want % INPUT_RING]);
+        c.appliedSeq = want;
+    } else if (c.newestSeq > 0) {
+        ++c.stats.inputsMissed;
+    }
+    return c.last;
+}
+
+unsigned MatchServer::tick(std::uint64_t nowMs)
+{
+    std::fill(inputs_.begin(), inputs_.end(), Input{});
+    for (Client& c : clients_) inputs_[std::size_t(c.slot)] = nextInput(c);
+
+    const unsigned ev = match_.step(inputs_.data());
+    history_[match_.tick() % net::HISTORY].capture(match_);
+
+    if (match_.tick() % std::uint64_t(sendEvery_) == 0)
+        for (Client& c : clients_) sendSnapshot(c, nowMs);
+    socket_.flush(nowMs);
+    return ev;
+}
+
+void MatchServer::sendSnapshot(Client& c, std::uint64_t nowMs)
+{
+    const std::uint32_t tick = std::uint32_t(match_.tick());
+    const NetState*     base = c.acked && tick - c.acked < net::HISTORY ? history(c.acked) : nullptr;
+    const int           age  = base ? int(tick - c.acked) : 0;
+    const std::uint32_t ackGuess = base ? c.ackSent[c.acked % net::HISTORY] + std::uint32_t(age) : 0;
+    c.ackSent[tick % net::HISTORY] = c.appliedSeq;
+
+    std::uint8_t buf[net::MAX_DATAGRAM];
+    net::Writer w(buf, sizeof buf);
+    w.u8(std::uint8_t(net::SNAPSHOT | age));
+    if (age) w.u8(std::uint8_t(tick));
+    else     w.var(tick);
+    const NetState* path[net::HISTORY];
+    for (int k = 1; k < age; ++k) path[k - 1] = &history_[(c.acked + std::uint32_t(k)) % net::HISTORY];
+    net::encodeDelta(match_.level(), base ? *base : blank_, age, path, history_[tick % net::HISTORY],
+                     std::int64_t(c.appliedSeq) - std::int64_t(ackGuess), guess_, w);
+    send(c, w, buf, nowMs);
+
+    ++c.stats.snapshots;
+    if (base) c.stats.baseAgeSum += tick - c.acked;
+    else      ++c.stats.fullSnapshots;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Match.hpp"
+#include "NetCodec.hpp"
+#include "UdpSocket.hpp"
+
+// authoritative host of a Match over UDP. Clients send their inputs every
+// tick; each tick the server applies one input per player, steps the match
+// and sends every client the new state as a delta against what it predicts
+// from the newest snapshot that client has acknowledged (or in full when
+// it has none the server still keeps). Nothing is resent: a lost snapshot
+// is covered by the next one, a lost input by the repeat count of the
+// following datagrams.
+class MatchServer {
+public:
+    static constexpr int TIMEOUT_MS = 5000;     // silence before a client is dropped
+    static constexpr int INPUT_RING = 64;       // inputs buffered per client, by sequence
+    static constexpr int MAX_INPUT_LAG = 6;     // queued inputs beyond this are skipped
+
+    // per client, for reports
+    struct Stats {
+        NetAddress    addr;
+        int           slot;
+        std::uint64_t bytesOut{0}, bytesIn{0};
+        std::uint64_t datagramsOut{0}, datagramsIn{0};
+        std::uint64_t snapshots{0}, fullSnapshots{0};
+        std::uint64_t baseAgeSum{0};             // ticks, over delta snapshots
+        std::uint64_t inputsMissed{0};           // ticks the previous input was reused
+    };
+
+    // throws if the level's pellet board cannot go out in one datagram
+    MatchServer(Match match, std::uint32_t ip, std::uint16_t port);
+
+    UdpSocket&  socket()      { return socket_; }
+    NetAddress  address() const { return socket_.localAddress(); }
+    const Match& match() const { return match_; }
+
+    // a snapshot every tick unless told otherwise
+    void setSendInterval(int ticks) { sendEvery_ = ticks < 1 ? 1 : ticks; }
+
+    void poll(std::uint64_t nowMs);     // handles every waiting datagram
+    unsigned tick(std::uint64_t nowMs); // steps the match, sends snapshots; SimEvent bits
+
+    // the state sent for tick t, while it is among the last net::HISTORY
+    const NetState* history(std::uint32_t t) const;
+
+    int                       clients() const { return int(clients_.size()); }
+    std::vector<Stats>        stats() const;
+
+private:
+    struct Client {
+        NetAddress    addr;
+        int           slot{-1};
+        std::uint64_t heardMs{0};
+        std::uint32_t acked{0};                 // newest snapshot tick confirmed, 0: none
+        std::uint32_t newestSeq{0};             // newest input received
+        std::uint32_t appliedSeq{0};            // last input stepped
+        std::array<std::uint32_t, net::HISTORY> ackSent{};  // appliedSeq sent, by tick % net::HISTORY
+        std::array<std::uint8_t, INPUT_RING>  input{};
+        std::array<std::uint32_t, INPUT_RING> inputSeq{};
+        Input         last;
+        Stats         stats;
+    };
+
+    void handle(const NetAddress& from, const std::uint8_t* data, std::size_t n, std::uint64_t nowMs);
+    void send(Client& c, net::Writer& w, const std::uint8_t* buf, std::uint64_t nowMs);
+    void sendSnapshot(Client& c, std::uint64_t nowMs);
+    Input nextInput(Client& c);
+
+    Match                    match_;
+    UdpSocket                socket_;
+    std::vector<Client>      clients_;
+    std::vector<NetState>    history_;      // by tick % net::HISTORY
+    NetState                 blank_, guess_;
+    std::vector<Input>       inputs_;       // per slot, this tick
+    std::uint32_t            levelHash_;
+    int                      sendEvery_{1};
+};
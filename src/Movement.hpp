@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include "Constants.hpp"
+#include "Geometry.hpp"
+#include "Level.hpp"
+
+// movement rules shared by Player, Ghost and BatchEnv.
+// Positions are Fixed2 (SUBPX units per pixel); every check below is integer
+// arithmetic, so a session plays out identically on any compiler and
+// optimisation level.
+
+inline constexpr Fixed2 dirStep(Dir d)
+{
+    switch (d) {
+        case Dir::Left:  return {-SPEED_FX,0};
+        case Dir::Right: return { SPEED_FX,0};
+        case Dir::Up:    return {0,-SPEED_FX};
+        case Dir::Down:  return {0, SPEED_FX};
+        default:         return {0,0};
+    }
+}
+
+inline constexpr Dir opposite(Dir d)
+{
+    switch (d) {
+        case Dir::Left:  return Dir::Right;
+        case Dir::Right: return Dir::Left;
+        case Dir::Up:    return Dir::Down;
+        case Dir::Down:  return Dir::Up;
+        default:         return Dir::None;
+    }
+}
+
+// tiles truncate toward zero like the original float code, so the strip
+// just left of x = 0 still counts as column 0
+inline constexpr Vec2i  tileOf(Fixed2 p)      { return {p.x / TILE_FX, p.y / TILE_FX}; }
+inline constexpr Fixed2 tileCenter(Vec2i t)   { return {TILE_FX*t.x + TILE_FX/2, TILE_FX*t.y + TILE_FX/2}; }
+inline Vec2             toPixels(Fixed2 p)    { return {float(p.x) / SUBPX, float(p.y) / SUBPX}; }
+
+// probe offsets of a body of COLL_RADIUS, straight and diagonal. A probe at
+// p + r falls in the same tile as the float probe did when rounded down on
+// the positive side and up on the negative side.
+namespace probe {
+    inline constexpr float R = COLL_RADIUS * SUBPX;
+    inline constexpr float D = COLL_RADIUS * 0.70710678f * SUBPX;
+    inline constexpr int R_POS = int(R), R_NEG = int(R) + (float(int(R)) < R);
+    inline constexpr int D_POS = int(D), D_NEG = int(D) + (float(int(D)) < D);
+
+    // offset past the centre, measured along the motion, from which the
+    // leading probe reaches the next tile; symmetric for the trailing probe
+    inline constexpr int CROSS = TILE_FX/2 - R_POS;
+    static_assert(TILE_FX/2 - R_POS == TILE_FX/2 + 1 - R_NEG,
+                  "leading and trailing probes must cross at the same offset");
+}
+
+// true if a body of COLL_RADIUS centred at p touches no wall (8 probes)
+inline bool canOccupy(const Level& lvl, Fixed2 p)
+{
+    using namespace probe;
+    const Fixed2 v[8]={
+        {p.x-R_NEG,p.y},{p.x+R_POS,p.y},
+        {p.x,p.y-R_NEG},{p.x,p.y+R_POS},
+        {p.x-D_NEG,p.y-D_NEG},{p.x+D_POS,p.y-D_NEG},
+        {p.x+D_POS,p.y+D_POS},{p.x-D_NEG,p.y+D_POS}};
+    for(auto q:v)
+        if(!lvl.isWalkable(q.x/TILE_FX,q.y/TILE_FX)) return false;
+    return true;
+}
+
+// canOccupy(p + dirStep(d)). A body on the centre line of its tile only
+// ever overlaps that tile and its neighbours along d, so away from the
+// maze border this is one lookup in the level's exits table and two
+// compares; everything else takes the full probe test.
+inline bool canMove(const Level& lvl, Fixed2 p, Dir d)
+{
+    const bool horiz = d == Dir::Left || d == Dir::Right;
+    const Vec2i  t = tileOf(p);
+    const Fixed2 c = tileCenter(t);
+    const int perp = horiz ? p.y - c.y : p.x - c.x;
+
+    if (d == Dir::None || perp != 0 || t.x < 1 || t.y < 1)
+        return canOccupy(lvl, p + dirStep(d));
+
+    const int sign  = (d == Dir::Right || d == Dir::Down) ? 1 : -1;
+    const int ahead = (horiz ? p.x - c.x : p.y - c.y) * sign + SPEED_FX;
+    const std::uint8_t m = lvl.exits(t.x, t.y);
+    if (!(m & Level::exitBit(Dir::None)))                                return false;
+    if (ahead >=  probe::CROSS && !(m & Level::exitBit(d)))              return false;
+    if (ahead <= -probe::CROSS && !(m & Level::exitBit(opposite(d))))    return false;
+    return true;
+}
+
+// horizontal wrap across the maze edge
+inline std::int32_t wrapX(std::int32_t x, std::int32_t mazeW)
+{
+    if(x < 0) return x + mazeW;
+    if(x > mazeW) return x - mazeW;
+    return x;
+}
+
+// jump to the paired tunnel end once per visit of a teleport tile
+inline void teleport(const Level& lvl, Fixed2& pos, bool& onTeleport)
+{
+    Vec2i g = tileOf(pos);
+    bool tp = lvl.isTeleport(g.x,g.y);
+    if(tp && !onTeleport){
+        pos = tileCenter(lvl.teleportDestination(g.x,g.y));
+        onTeleport = true;
+    } else if(!tp){
+        onTeleport = false;
+    }
+}
+
+inline void wrapAndTeleport(const Level& lvl, Fixed2& pos, bool& onTeleport)
+{
+    pos.x = wrapX(pos.x, lvl.width()*TILE_FX);
+    teleport(lvl, pos, onTeleport);
+}
+
+// player steering: take the queued turn near a tile centre, then advance
+// or stop against a wall
+inline void steerAndMove(const Level& lvl, Fixed2& pos, Dir& cur, Dir next)
+{
+    constexpr int TURN_TOL = TILE_FX / 5;      // a fifth of a tile either side
+
+    const Fixed2 from = pos;
+    const Fixed2 center = tileCenter(tileOf(from));
+
+    if(next!=cur){
+        Fixed2 toC=center-from;
+        if(std::abs(toC.x)<=TURN_TOL && std::abs(toC.y)<=TURN_TOL &&
+           canMove(lvl,from,next)){
+            pos=center;
+            cur=next;
+        }
+    }
+
+    if(canMove(lvl,from,cur)) pos+=dirStep(cur);
+    else cur=Dir::None;
+}
+
+// squared collision distance between two bodies, in SUBPX units: the float
+// rule hypot(d) < 2*COLL_RADIUS on integer inputs
+inline constexpr std::int64_t HIT_DIST2 = [] {
+    const double r  = double(COLL_RADIUS * 2 * SUBPX);
+    const double r2 = r * r;
+    return std::int64_t(r2) + (double(std::int64_t(r2)) < r2);
+}();
+
+inline bool touching(Fixed2 a, Fixed2 b)
+{
+    const std::int64_t dx = a.x - b.x, dy = a.y - b.y;
+    return dx*dx + dy*dy < HIT_DIST2;
+}
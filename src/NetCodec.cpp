@@ -0,0 +1,335 @@
+#include "NetCodec.hpp"
+#include "Match.hpp"
+#include "Movement.hpp"
+#include <bit>
+#include <stdexcept>
+
+void NetState::blank(std::size_t slotCount, std::size_t pelletWords)
+{
+    tick  = 0;
+    flags = 0;
+    slots.assign(slotCount, Slot{Fixed2{}, Dir::None, Dir::None, 0, 0, 0});
+    pellets.assign(pelletWords, 0);
+}
+
+void NetState::capture(const Match& m)
+{
+    tick  = std::uint32_t(m.tick());
+    flags = std::uint8_t((m.gameOver() ? GAME_OVER : 0) | (m.levelCleared() ? LEVEL_CLEARED : 0));
+    slots.resize(std::size_t(m.slots()));
+    for (int i = 0; i < m.slots(); ++i) {
+        const Match::Slot& s = m.slot(i);
+        Slot& o   = slots[std::size_t(i)];
+        o.pos     = s.position();
+        o.heading = s.heading();
+        o.facing  = s.facing();
+        o.flags   = std::uint8_t((s.taken ? TAKEN : 0) | (s.out ? OUT : 0));
+        o.lives   = s.lives;
+        o.score   = s.score;
+    }
+    const Level& lvl = m.level();
+    pellets.assign(lvl.pellets(), lvl.pellets() + lvl.bitboardWords());
+}
+
+namespace net {
+
+namespace {
+
+// above the slot bits of the changes word
+enum Extra : std::uint8_t { X_FLAGS = 1, X_ACK = 2, X_PELLETS = 4 };
+// slot head (turn count in bits 4-6, F_HEAD set); F_MORE's byte
+enum Field : std::uint8_t { F_X = 1, F_Y = 2, F_DIRS = 4, F_MORE = 8, F_HEAD = 0x80 };
+enum More  : std::uint8_t { F_FLAGS = 1, F_LIVES = 2, F_SCORE = 4 };
+
+constexpr int MAX_TURNS = 7;        // per slot and snapshot, in the head's bits 4-6
+constexpr int MAX_SLOTS = 16;       // ample for Match::MAX_SLOTS
+
+static_assert(Match::MAX_SLOTS <= MAX_SLOTS);
+static_assert(net::HISTORY <= 64, "a turn's tick takes six bits");
+
+// the turns a delta reports, per slot: tick after the baseline << 2 | kind
+struct Turns {
+    std::uint8_t n[MAX_SLOTS]{};
+    std::uint8_t at[MAX_SLOTS][MAX_TURNS];
+};
+
+std::int64_t steps(std::int32_t from, std::int32_t to)
+{
+    const std::int64_t d = std::int64_t(to) - from;
+    if (d % SPEED_FX) throw std::runtime_error("position off the movement lattice");
+    return d / SPEED_FX;
+}
+
+std::size_t varBytes(std::uint64_t v) { return v < 0x80 ? 1 : std::size_t(std::bit_width(v) + 6) / 7; }
+
+std::uint8_t packDirs(const NetState::Slot& s) { return std::uint8_t(int(s.heading) | int(s.facing) << 3); }
+
+bool inPlay(const NetState::Slot& s) { return (s.flags & NetState::TAKEN) && !(s.flags & NetState::OUT); }
+
+// a turn in two bits: from a heading, stop, the two perpendiculars or
+// back; from standing still, one of the four ways
+Dir turnTo(Dir from, unsigned kind)
+{
+    static constexpr Dir FROM_NONE[4]  = {Dir::Left, Dir::Right, Dir::Up, Dir::Down};
+    static constexpr Dir ACROSS_H[2]   = {Dir::Up, Dir::Down};
+    static constexpr Dir ACROSS_V[2]   = {Dir::Left, Dir::Right};
+    if (from == Dir::None) return FROM_NONE[kind];
+    if (kind == 0) return Dir::None;
+    if (kind == 3) return opposite(from);
+    return from == Dir::Left || from == Dir::Right ? ACROSS_H[kind - 1] : ACROSS_V[kind - 1];
+}
+
+// the kind turnTo(from, kind) gives to, or 4 when none does
+unsigned kindOf(Dir from, Dir to)
+{
+    unsigned k = 0;
+    while (k < 4 && turnTo(from, k) != to) ++k;
+    return k;
+}
+
+// Player::update: a pac-man eats where it stands before it moves
+void eat(const Level& lvl, NetState& g, std::size_t i)
+{
+    NetState::Slot& s = g.slots[i];
+    const Vec2i t = tileOf(s.pos);
+    if (!lvl.inGrid(t.x, t.y)) return;
+    const std::size_t bit  = lvl.bit(t.x, t.y);
+    std::uint64_t&    word = g.pellets[bit >> 6];
+    if (!(word >> (bit & 63) & 1)) return;
+    word &= ~(1ull << (bit & 63));
+    s.score += Simulation::PELLET_SCORE;
+}
+
+// a tick where nothing new happens: a body goes on until a wall stops
+// it, an AI ghost around the bends of its corridor and straight over
+// junctions
+void follow(const Level& lvl, NetState::Slot& s, bool ai)
+{
+    if (ai && Ghost::needsDecision(lvl, s.pos, s.heading)) {
+        const Dir d = Ghost::corridorHeading(lvl, s.pos, s.heading);
+        if (d != Dir::None) s.heading = d;
+    }
+    if (s.heading == Dir::None) return;
+    if (canMove(lvl, s.pos, s.heading)) {
+        s.pos   += dirStep(s.heading);
+        s.facing = s.heading;
+    } else {
+        s.heading = Dir::None;
+    }
+}
+
+// a tick where the body took a turn follow() could not foresee; bodies
+// turn at the centre of their tile
+void turn(NetState::Slot& s, Dir to)
+{
+    if (to != Dir::None) {
+        if (to != s.heading) s.pos = tileCenter(tileOf(s.pos));
+        s.pos   += dirStep(to);
+        s.facing = to;
+    }
+    s.heading = to;
+}
+
+bool isPacMan(std::size_t i) { return i < std::size_t(Match::MAX_PACMEN); }
+bool isAi(const NetState& g, std::size_t i) { return !isPacMan(i) && !(g.slots[i].flags & NetState::TAKEN); }
+bool moves(const NetState& g, std::size_t i) { return !isPacMan(i) || inPlay(g.slots[i]); }
+
+// base carried on by age ticks, taking the turns; the guess both ends
+// take a delta against. Nothing moves once the game is over.
+void predict(const Level& lvl, const NetState& base, int age, const Turns& turns, NetState& out)
+{
+    out = base;
+    out.tick = base.tick + std::uint32_t(age);
+    if (base.flags) return;
+
+    int next[MAX_SLOTS]{};
+    for (int k = 0; k < age; ++k)
+        for (std::size_t i = 0; i < out.slots.size(); ++i) {
+            if (!moves(out, i)) continue;
+            if (isPacMan(i)) eat(lvl, out, i);
+            NetState::Slot& s = out.slots[i];
+            const int j = next[i];
+            if (j < turns.n[i] && turns.at[i][j] >> 2 == k) {
+                turn(s, turnTo(s.heading, turns.at[i][j] & 3u));
+                ++next[i];
+            } else {
+                follow(lvl, s, isAi(out, i));
+            }
+        }
+}
+
+}
+
+void encodeDelta(const Level& lvl, const NetState& base, int age, const NetState* const* path,
+                 const NetState& cur, std::int64_t ackOff, NetState& guess, Writer& w)
+{
+    // predict() step by step against what happened, noting the turns it missed
+    Turns turns;
+    guess = base;
+    guess.tick = base.tick + std::uint32_t(age);
+    for (int k = 0; k < age && !base.flags; ++k) {
+        const NetState& then = k + 1 == age ? cur : *path[k];
+        for (std::size_t i = 0; i < guess.slots.size(); ++i) {
+            if (!moves(guess, i)) continue;
+            if (isPacMan(i)) eat(lvl, guess, i);
+            NetState::Slot& s = guess.slots[i];
+            const NetState::Slot was = s;
+            follow(lvl, s, isAi(guess, i));
+            const Dir      want = then.slots[i].heading;
+            const unsigned kind = kindOf(was.heading, want);
+            if (s.heading == want || kind > 3 || turns.n[i] == MAX_TURNS) continue;
+            s = was;
+            turn(s, want);
+            turns.at[i][turns.n[i]++] = std::uint8_t(k << 2 | kind);
+        }
+    }
+
+    std::uint64_t changed = 0;
+    for (std::size_t i = 0; i < cur.slots.size(); ++i)
+        if (turns.n[i] || !(cur.slots[i] == guess.slots[i])) changed |= 1ull << i;
+    const bool pellets = cur.pellets != guess.pellets;
+    const std::uint64_t extra = (cur.flags != guess.flags ? X_FLAGS : 0) | (ackOff ? X_ACK : 0)
+                              | (pellets ? X_PELLETS : 0);
+    w.var(changed | extra << cur.slots.size());
+    if (extra & X_FLAGS) w.u8(cur.flags);
+    if (extra & X_ACK)   w.zz(ackOff);
+
+    std::uint8_t more[MAX_SLOTS]{};
+    std::uint8_t head[MAX_SLOTS]{};
+    for (std::size_t i = 0; i < cur.slots.size(); ++i) {
+        if (!(changed >> i & 1)) continue;
+        const NetState::Slot& a = guess.slots[i];
+        const NetState::Slot& b = cur.slots[i];
+        more[i] = std::uint8_t(
+              (a.flags != b.flags ? F_FLAGS : 0) | (a.lives != b.lives ? F_LIVES : 0)
+            | (a.score != b.score ? F_SCORE : 0));
+        head[i] = std::uint8_t(
+              (a.pos.x != b.pos.x ? F_X : 0) | (a.pos.y != b.pos.y ? F_Y : 0)
+            | (packDirs(a) != packDirs(b) ? F_DIRS : 0) | (more[i] ? F_MORE : 0));
+        // the common change, one turn and nothing else, is the turn's byte
+        if (!head[i] && turns.n[i] == 1 && turns.at[i][0] < F_HEAD) {
+            w.u8(turns.at[i][0]);
+            continue;
+        }
+        head[i] |= std::uint8_t(F_HEAD | turns.n[i] << 4);
+        w.u8(head[i]);
+        for (int j = 0; j < turns.n[i]; ++j) w.u8(turns.at[i][j]);
+    }
+    for (std::size_t i = 0; i < cur.slots.size(); ++i) {
+        if (!(changed >> i & 1)) continue;
+        const NetState::Slot& a = guess.slots[i];
+        const NetState::Slot& b = cur.slots[i];
+        if (head[i] & F_X)    w.zz(steps(a.pos.x, b.pos.x));
+        if (head[i] & F_Y)    w.zz(steps(a.pos.y, b.pos.y));
+        if (head[i] & F_DIRS) w.u8(packDirs(b));
+        if (!more[i]) continue;
+        w.u8(more[i]);
+        if (more[i] & F_FLAGS) w.u8(b.flags);
+        if (more[i] & F_LIVES) w.zz(std::int64_t(b.lives) - a.lives);
+        if (more[i] & F_SCORE) w.zz(std::int64_t(b.score) - a.score);
+    }
+    if (!pellets) return;
+
+    // the bits that differ, gap coded, unless the whole board is shorter
+    std::size_t count = 0, listBytes = 0, last = 0;
+    for (std::size_t k = 0; k < cur.pellets.size(); ++k)
+        for (std::uint64_t d = cur.pellets[k] ^ guess.pellets[k]; d; d &= d - 1) {
+            const std::size_t bit = k * 64 + std::size_t(std::countr_zero(d));
+            listBytes += varBytes(bit - last);
+            last = bit;
+            ++count;
+        }
+    if (listBytes > cur.pellets.size() * 8) {
+        w.var(1);
+        for (std::uint64_t word : cur.pellets) w.u64(word);
+        return;
+    }
+    w.var(std::uint64_t(count) << 1);
+    last = 0;
+    for (std::size_t k = 0; k < cur.pellets.size(); ++k)
+        for (std::uint64_t d = cur.pellets[k] ^ guess.pellets[k]; d; d &= d - 1) {
+            const std::size_t bit = k * 64 + std::size_t(std::countr_zero(d));
+            w.var(bit - last);
+            last = bit;
+        }
+}
+
+bool decodeDelta(const Level& lvl, const NetState& base, int age, Reader& r,
+                 NetState& guess, NetState& out, std::int64_t& ackOff)
+{
+    const std::size_t   n       = base.slots.size();
+    const std::uint64_t changes = r.var();
+    const std::uint64_t changed = changes & ((1ull << n) - 1);
+    const std::uint64_t extra   = changes >> n;
+    if (n > std::size_t(MAX_SLOTS) || extra >> 3) return false;
+    const std::uint8_t flags = extra & X_FLAGS ? r.u8() : base.flags;
+    ackOff = extra & X_ACK ? r.zz() : 0;
+
+    Turns turns;
+    std::uint8_t head[MAX_SLOTS]{};
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!(changed >> i & 1)) continue;
+        const std::uint8_t h = r.u8();
+        if (h & F_HEAD) {
+            head[i]    = h;
+            turns.n[i] = h >> 4 & 7;
+        } else {
+            turns.n[i] = 1;
+        }
+        for (int j = 0; j < turns.n[i]; ++j) {
+            turns.at[i][j] = h & F_HEAD ? r.u8() : h;
+            const int k = turns.at[i][j] >> 2;
+            if (k >= age || base.flags || (j && k <= turns.at[i][j - 1] >> 2)) return false;
+        }
+    }
+    if (!r.ok()) return false;
+
+    predict(lvl, base, age, turns, guess);
+    out.flags   = flags;
+    out.slots   = guess.slots;
+    out.pellets = guess.pellets;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!(changed >> i & 1)) continue;
+        NetState::Slot& s = out.slots[i];
+        if (head[i] & F_X)    s.pos.x += std::int32_t(r.zz() * SPEED_FX);
+        if (head[i] & F_Y)    s.pos.y += std::int32_t(r.zz() * SPEED_FX);
+        if (head[i] & F_DIRS) { const std::uint8_t d = r.u8(); s.heading = Dir(d & 7); s.facing = Dir(d >> 3 & 7); }
+        if (!(head[i] & F_MORE)) continue;
+        const std::uint8_t more = r.u8();
+        if (more & F_FLAGS) s.flags = r.u8();
+        if (more & F_LIVES) s.lives = std::int32_t(s.lives + r.zz());
+        if (more & F_SCORE) s.score = std::uint32_t(s.score + r.zz());
+    }
+    if (!(extra & X_PELLETS)) return r.ok();
+
+    const std::uint64_t pel = r.var();
+    if (pel & 1) {
+        for (std::uint64_t& word : out.pellets) word = r.u64();
+    } else {
+        const std::size_t bits = out.pellets.size() * 64;
+        std::size_t bit = 0;
+        for (std::uint64_t i = 0; i < pel >> 1 && r.ok(); ++i) {
+            bit += std::size_t(r.var());
+            if (bit >= bits) return false;
+            out.pellets[bit >> 6] ^= 1ull << (bit & 63);
+        }
+    }
+    return r.ok();
+}
+
+std::uint32_t levelHash(const Level& lvl)
+{
+    // FNV-1a
+    std::uint32_t h = 2166136261u;
+    auto mix = [&h](std::uint32_t v) {
+        for (int i = 0; i < 4; ++i) { h ^= (v >> (8 * i)) & 0xFF; h *= 16777619u; }
+    };
+    mix(std::uint32_t(lvl.width()));
+    mix(std::uint32_t(lvl.height()));
+    for (int y = 0; y < lvl.height(); ++y)
+        for (int x = 0; x < lvl.width(); ++x)
+            mix(std::uint32_t(lvl.isWalkable(x, y)) | std::uint32_t(lvl.initialPellet(x, y)) << 1);
+    return h;
+}
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Geometry.hpp"
+#include "Level.hpp"
+
+class Match;
+
+// what a client sees of one match tick: every slot and the pellet board.
+// The rng, the AI ghosts' inner state and spawn grace stay on the server.
+struct NetState {
+    struct Slot {
+        Fixed2        pos{};
+        Dir           heading{Dir::None};    // curDir
+        Dir           facing{Dir::Right};
+        std::uint8_t  flags{0};              // TAKEN | OUT
+        std::int32_t  lives{0};
+        std::uint32_t score{0};
+
+        bool operator==(const Slot&) const = default;
+    };
+    static constexpr std::uint8_t TAKEN = 1, OUT = 2;                 // Slot::flags
+    static constexpr std::uint8_t GAME_OVER = 1, LEVEL_CLEARED = 2;   // flags
+
+    std::uint32_t              tick{0};
+    std::uint8_t               flags{0};
+    std::vector<Slot>          slots;
+    std::vector<std::uint64_t> pellets;      // Level::pellets() words
+
+    // an all-zero state of the right shape, the baseline of a full snapshot
+    void blank(std::size_t slotCount, std::size_t pelletWords);
+    void capture(const Match& m);            // allocation-free once shaped
+
+    bool operator==(const NetState&) const = default;
+};
+
+// wire format shared by MatchServer and MatchClient. All integers are
+// little-endian; "var" is LEB128 and "zz" a zigzag LEB128.
+//
+//   HELLO     magic u32 | version u8 | role u8
+//   WELCOME   slot u8 | slots u8 | level hash u32
+//   FULL      (no free slot of that role)
+//   INPUT     seq u8 | ack u8 | input u8: inputlog::pack | repeats << 4 | acking << 7
+//   SNAPSHOT  (type byte | base age, 0: none) tick (age ? u8 : var) | delta
+//   BYE
+//
+// An INPUT stands for its sequence number and the `repeats` (up to
+// INPUT_REDUNDANCY - 1) before it, which held the same input; ack is the
+// newest snapshot tick the client holds, when acking. Sequence numbers and
+// delta snapshot ticks travel as their low 8 bits; the receiver widens them
+// next to the last full value it knows (unwrap8).
+//
+// A snapshot is a delta against a guess both ends can make from the
+// baseline: age ticks of bodies going on the way they were, pac-men eating
+// as they go, AI ghosts taking the bends of their corridors and nothing
+// moving once the game is over, plus the turns the delta lists. A tick
+// that went as guessed costs nothing past the header, and a turn a byte
+// for as long as the baseline predates it. The input ack rides along
+// against its own guess: the baseline's ack plus age, an input a tick.
+//
+//   changes var: a bit per changed slot, then FLAGS, ACK and PELLETS above those |
+//   flags u8 | ack zz |
+//   per changed slot: head u8: F_X | F_Y | F_DIRS | F_MORE | turns << 4 | 0x80 |
+//     turns u8: ticks after the baseline << 2 | kind
+//       (kind from a heading: stop, the two perpendiculars in Dir order,
+//       back; from none: the four ways in Dir order. A slot whose only
+//       change is one turn in the first 32 ticks sends just that turn.)
+//   per changed slot: x zz | y zz | dirs u8 | more u8: F_FLAGS | F_LIVES | F_SCORE |
+//     flags u8 | lives zz | score zz
+//     (only the fields present; positions in SPEED_FX steps, all relative
+//     to the guess)
+//   pellets var (count << 1 | raw) | raw: every word | else: count gaps
+//     var between the bits that differ from the guess
+namespace net {
+
+inline constexpr std::uint32_t MAGIC   = 0x504E4D50;   // "PMNP"
+inline constexpr std::uint8_t  VERSION = 2;      // 2: deltas against a guess, one-byte inputs
+inline constexpr std::size_t   MAX_DATAGRAM = 1200;    // stays under any path MTU
+inline constexpr int           HISTORY = 64;           // snapshots kept for baselines, both ends
+inline constexpr int           INPUT_REDUNDANCY = 8;   // ticks of one held input an INPUT can stand for
+inline constexpr std::uint8_t  INPUT_ACKING = 0x80;    // INPUT's input byte: ack is a tick the client holds
+inline constexpr int           IP_UDP_HEADER = 28;     // IPv4 + UDP bytes per datagram, for reports
+
+// a snapshot's type byte carries its base age in the bits below SNAPSHOT
+enum Msg : std::uint8_t { HELLO = 1, WELCOME, FULL, INPUT, BYE, SNAPSHOT = 0x40 };
+inline constexpr std::uint8_t AGE_MASK = SNAPSHOT - 1;
+static_assert(HISTORY <= AGE_MASK + 1, "a base age must fit below SNAPSHOT");
+static_assert(INPUT_REDUNDANCY <= 8, "repeats must fit in three bits");
+
+// bounded writer; a message that does not fit sets overflow()
+class Writer {
+public:
+    Writer(std::uint8_t* buf, std::size_t cap) : p_(buf), cap_(cap) {}
+
+    void u8(std::uint8_t v)   { if (n_ < cap_) p_[n_++] = v; else overflow_ = true; }
+    void u16(std::uint16_t v) { u8(std::uint8_t(v)); u8(std::uint8_t(v >> 8)); }
+    void u32(std::uint32_t v) { u16(std::uint16_t(v)); u16(std::uint16_t(v >> 16)); }
+    void u64(std::uint64_t v) { u32(std::uint32_t(v)); u32(std::uint32_t(v >> 32)); }
+    void var(std::uint64_t v)
+    {
+        while (v >= 0x80) { u8(std::uint8_t(v | 0x80)); v >>= 7; }
+        u8(std::uint8_t(v));
+    }
+    void zz(std::int64_t v) { var((std::uint64_t(v) << 1) ^ std::uint64_t(v >> 63)); }
+
+    std::size_t size()     const { return n_; }
+    bool        overflow() const { return overflow_; }
+
+private:
+    std::uint8_t* p_;
+    std::size_t   cap_, n_{0};
+    bool          overflow_{false};
+};
+
+// reading past the end yields zeros and clears ok()
+class Reader {
+public:
+    Reader(const std::uint8_t* buf, std::size_t n) : p_(buf), end_(buf + n) {}
+
+    std::uint8_t  u8()  { if (p_ < end_) return *p_++; ok_ = false; return 0; }
+    std::uint16_t u16() { std::uint16_t v = u8(); return std::uint16_t(v | u8() << 8); }
+    std::uint32_t u32() { std::uint32_t v = u16(); return v | std::uint32_t(u16()) << 16; }
+    std::uint64_t u64() { std::uint64_t v = u32(); return v | std::uint64_t(u32()) << 32; }
+    std::uint64_t var()
+    {
+        std::uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const std::uint8_t b = u8();
+            v |= std::uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok_ = false;
+        return v;
+    }
+    std::int64_t zz() { const std::uint64_t v = var(); return std::int64_t(v >> 1) ^ -std::int64_t(v & 1); }
+
+    bool ok()   const { return ok_; }
+    bool done() const { return p_ == end_; }
+
+private:
+    const std::uint8_t* p_;
+    const std::uint8_t* end_;
+    bool                ok_{true};
+};
+
+// the full value whose low 8 bits are low, nearest to near
+inline std::uint32_t unwrap8(std::uint32_t near, std::uint8_t low)
+{
+    return near + std::uint32_t(std::int8_t(std::uint8_t(low - std::uint8_t(near))));
+}
+
+// cur as changes to the guess both ends can make from base, age ticks
+// older: path[k] for k < age - 1 is the state k + 1 ticks after base, and
+// ackOff the input ack's distance from its guess. A full snapshot is age
+// 0 against a blank base. guess is scratch. Throws if a position is off
+// the SPEED_FX lattice every body moves on.
+void encodeDelta(const Level& lvl, const NetState& base, int age, const NetState* const* path,
+                 const NetState& cur, std::int64_t ackOff, NetState& guess, Writer& w);
+// false on a malformed or mis-shaped delta; guess is scratch, and neither
+// it nor out may be base
+bool decodeDelta(const Level& lvl, const NetState& base, int age, Reader& r,
+                 NetState& guess, NetState& out, std::int64_t& ackOff);
+
+// identifies a level's layout, so a client can tell it loaded the
+// server's: size, walls and starting pellets
+std::uint32_t levelHash(const Level& lvl);
+
+}
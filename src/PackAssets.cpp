@@ -0,0 +1,90 @@
+#include "AssetArchive.hpp"
+#include <SFML/Audio.hpp>
+#include <SFML/Graphics.hpp>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// build step: packs resources into one archive, decoding WAV to PCM and
+// PNG to RGBA on the way.
+// usage: PacManPack OUT.pak FILE...
+namespace {
+bool endsWith(const std::string& s, const char* suffix)
+{
+    std::size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " OUT.pak FILE...\n";
+        return 1;
+    }
+
+    const int count = argc - 2;
+    std::vector<AssetArchive::Entry> entries(count);
+    std::vector<std::vector<char>>   payloads(count);
+
+    for (int i = 0; i < count; ++i) {
+        const std::string path = argv[i + 2];
+        auto& e = entries[i];
+        auto& p = payloads[i];
+        std::memset(&e, 0, sizeof e);
+        if (path.size() >= AssetArchive::NAME) {
+            std::cerr << "ERROR: name too long " << path << '\n';
+            return 1;
+        }
+        std::memcpy(e.name, path.data(), path.size());
+
+        if (endsWith(path, ".wav")) {
+            sf::SoundBuffer buf;
+            if (!buf.loadFromFile(path)) { std::cerr << "ERROR: cannot load " << path << '\n'; return 1; }
+            e.kind = AssetArchive::Kind::Pcm16;
+            e.a    = buf.getChannelCount();
+            e.b    = buf.getSampleRate();
+            const char* s = reinterpret_cast<const char*>(buf.getSamples());
+            p.assign(s, s + buf.getSampleCount() * sizeof(std::int16_t));
+        } else if (endsWith(path, ".png")) {
+            sf::Image img;
+            if (!img.loadFromFile(path)) { std::cerr << "ERROR: cannot load " << path << '\n'; return 1; }
+            e.kind = AssetArchive::Kind::Rgba8;
+            e.a    = img.getSize().x;
+            e.b    = img.getSize().y;
+            const char* s = reinterpret_cast<const char*>(img.getPixelsPtr());
+            p.assign(s, s + std::size_t(e.a) * e.b * 4);
+        } else {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) { std::cerr << "ERROR: cannot load " << path << '\n'; return 1; }
+            e.kind = AssetArchive::Kind::Raw;
+            p.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        e.size = p.size();
+    }
+
+    // lay out payloads after the index, 16-byte aligned
+    std::uint64_t offset = sizeof(AssetArchive::Header) + count * sizeof(AssetArchive::Entry);
+    for (auto& e : entries) {
+        offset = (offset + 15) & ~std::uint64_t(15);
+        e.offset = offset;
+        offset += e.size;
+    }
+
+    std::ofstream out(argv[1], std::ios::binary | std::ios::trunc);
+    AssetArchive::Header h{AssetArchive::MAGIC, AssetArchive::VERSION, std::uint32_t(count), 0};
+    out.write(reinterpret_cast<const char*>(&h), sizeof h);
+    out.write(reinterpret_cast<const char*>(entries.data()), std::streamsize(count * sizeof(AssetArchive::Entry)));
+    for (int i = 0; i < count; ++i) {
+        while (std::uint64_t(out.tellp()) < entries[i].offset) out.put('\0');
+        out.write(payloads[i].data(), std::streamsize(payloads[i].size()));
+    }
+    if (!out) {
+        std::cerr << "ERROR: cannot write " << argv[1] << '\n';
+        return 1;
+    }
+    std::cout << "packed " << count << " assets into " << argv[1] << " (" << offset << " bytes)\n";
+}
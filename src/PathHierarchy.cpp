@@ -0,0 +1,254 @@
+#include "PathHierarchy.hpp"
+#include "Level.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+
+namespace {
+
+// per-thread search state, reused between queries; g and done are valid
+// only where their stamp is the current one, so a query clears nothing
+struct Search {
+    struct Open { std::uint32_t f, g, node; };
+
+    std::vector<std::uint32_t> g, seen, done;
+    std::uint32_t              stamp{0};
+    std::vector<Open>          open;
+    std::vector<std::uint16_t> fromDist, toDist;
+
+    void begin(std::size_t nodes, std::size_t cells)
+    {
+        if (g.size() != nodes || ++stamp == 0) {
+            g.assign(nodes, 0);
+            seen.assign(nodes, 0);
+            done.assign(nodes, 0);
+            stamp = 1;
+        }
+        open.clear();
+        fromDist.resize(cells);
+        toDist.resize(4 * cells);
+    }
+};
+
+thread_local Search scratch;
+
+// f = 4g + 5h: the heuristic counts a quarter extra. On open floor every
+// entrance between the two ends lies on some shortest path, and exact A*
+// would settle all of them before it may stop; leaning on h follows one
+// of them instead, for paths at most a quarter (in practice a few tiles)
+// longer than the hierarchy's best
+constexpr std::uint32_t G_WEIGHT = 4, H_WEIGHT = 5;
+
+// lowest f first, then the deepest, which walks straight along ties
+bool later(const Search::Open& a, const Search::Open& b)
+{
+    return a.f != b.f ? a.f > b.f : a.g < b.g;
+}
+
+}
+
+void PathHierarchy::build(const Level& lvl)
+{
+    w_  = lvl.width();
+    h_  = lvl.height();
+    cw_ = (w_ + CLUSTER - 1) / CLUSTER;
+    ch_ = (h_ + CLUSTER - 1) / CLUSTER;
+    clusters_.assign(std::size_t(cw_) * ch_, Cluster{});
+    for (int c = 0; c < int(clusters_.size()); ++c) buildCluster(lvl, c);
+}
+
+void PathHierarchy::invalidate(const Level& lvl, Vec2i t)
+{
+    if (empty() || t.x < 0 || t.y < 0 || t.x >= w_ || t.y >= h_) return;
+    const int c = clusterOf(t);
+    const int lx = t.x % CLUSTER, ly = t.y % CLUSTER;
+    buildCluster(lvl, c);
+    if (lx == 0 && t.x > 0)                     buildCluster(lvl, c - 1);
+    if (lx == CLUSTER - 1 && t.x + 1 < w_)      buildCluster(lvl, c + 1);
+    if (ly == 0 && t.y > 0)                     buildCluster(lvl, c - cw_);
+    if (ly == CLUSTER - 1 && t.y + 1 < h_)      buildCluster(lvl, c + cw_);
+}
+
+std::size_t PathHierarchy::entrances() const
+{
+    std::size_t n = 0;
+    for (const Cluster& c : clusters_) n += c.first[4];
+    return n;
+}
+
+// entrances side by side, each the middle of a run of tiles open on both
+// sides of the border; a neighbour finds the same runs in the same order,
+// so run k of one side pairs with run k of the other
+void PathHierarchy::buildCluster(const Level& lvl, int c)
+{
+    const Vec2i o = origin(c);
+    const int   w = std::min(CLUSTER, w_ - o.x), h = std::min(CLUSTER, h_ - o.y);
+    Cluster&    cl = clusters_[std::size_t(c)];
+    cl = Cluster{};
+
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            if (lvl.isWalkable(o.x + x, o.y + y)) {
+                const int i = x | y << 4;
+                cl.open[std::size_t(i >> 6)] |= 1ull << (i & 63);
+            }
+
+    int n = 0;
+    for (int s = Left; s <= Down; ++s) {
+        cl.first[std::size_t(s)] = std::uint8_t(n);
+        const int len = s == Left || s == Right ? h : w;
+        int start = -1;
+        for (int k = 0; k <= len; ++k) {
+            bool open = false;
+            Vec2i in{};
+            if (k < len) {
+                in = s == Left  ? Vec2i{0, k}     : s == Right ? Vec2i{w - 1, k}
+                   : s == Up    ? Vec2i{k, 0}     :              Vec2i{k, h - 1};
+                const int dx = s == Left ? -1 : s == Right ? 1 : 0;
+                const int dy = s == Up   ? -1 : s == Down  ? 1 : 0;
+                open = lvl.isWalkable(o.x + in.x, o.y + in.y)
+                    && lvl.isWalkable(o.x + in.x + dx, o.y + in.y + dy);
+            }
+            if (open && start < 0) start = k;
+            if (!open && start >= 0) {
+                const int mid = (start + k - 1) / 2;
+                const Vec2i m = s == Left  ? Vec2i{0, mid}     : s == Right ? Vec2i{w - 1, mid}
+                              : s == Up    ? Vec2i{mid, 0}     :              Vec2i{mid, h - 1};
+                cl.at[std::size_t(n++)] = std::uint8_t(m.x | m.y << 4);
+                start = -1;
+            }
+        }
+    }
+    cl.first[4] = std::uint8_t(n);
+
+    std::uint16_t d[CELLS];
+    for (int i = 0; i < n; ++i) {
+        bfs(c, tileOf(c, i), d);
+        for (int j = 0; j < n; ++j) cl.dist[std::size_t(i)][std::size_t(j)] = d[cl.at[std::size_t(j)]];
+    }
+}
+
+// distances inside cluster c from a walkable tile of it, by local tile:
+// the cluster is 256 bits, four rows to a word, and a whole BFS layer is a
+// few shifts of them
+void PathHierarchy::bfs(int c, Vec2i from, std::uint16_t* dist) const
+{
+    constexpr std::uint64_t NOT_FIRST = 0xFFFEFFFEFFFEFFFEull;   // column 0 of each row clear
+    constexpr std::uint64_t NOT_LAST  = 0x7FFF7FFF7FFF7FFFull;   // column 15 clear
+    constexpr int           WORDS     = CELLS / 64;
+
+    const Cluster& cl = clusters_[std::size_t(c)];
+    const Vec2i    o  = origin(c);
+    std::fill(dist, dist + CELLS, NO_PATH);
+
+    const int start = (from.x - o.x) | (from.y - o.y) << 4;
+    std::uint64_t seen[WORDS]{}, front[WORDS]{};
+    front[start >> 6] = seen[start >> 6] = 1ull << (start & 63);
+    dist[start] = 0;
+    for (std::uint16_t d = 1;; ++d) {
+        std::uint64_t next[WORDS], any = 0;
+        for (int k = 0; k < WORDS; ++k) {
+            std::uint64_t n = (front[k] << 1 & NOT_FIRST) | (front[k] >> 1 & NOT_LAST)
+                            | front[k] << 16 | front[k] >> 16;
+            if (k > 0)         n |= front[k - 1] >> 48;
+            if (k + 1 < WORDS) n |= front[k + 1] << 48;
+            next[k] = n & cl.open[std::size_t(k)] & ~seen[k];
+            any |= next[k];
+        }
+        if (!any) return;
+        for (int k = 0; k < WORDS; ++k) {
+            seen[k] |= next[k];
+            front[k] = next[k];
+            for (std::uint64_t m = next[k]; m; m &= m - 1) dist[k << 6 | std::countr_zero(m)] = d;
+        }
+    }
+}
+
+void PathHierarchy::distances(const Level& lvl, Vec2i from, const Vec2i* to, int n, std::uint32_t* out) const
+{
+    for (int i = 0; i < n; ++i) out[i] = UNREACHABLE;
+    if (empty() || !lvl.isWalkable(from.x, from.y)) return;
+
+    Search& s = scratch;
+    s.begin(clusters_.size() * MAX_ENTRANCES, CELLS);
+
+    // both ends inside their own cluster; a target in the start's cluster
+    // may also be reached without leaving it
+    const int cf = clusterOf(from);
+    bfs(cf, from, s.fromDist.data());
+    int  ct[4];
+    bool live[4]{};
+    for (int i = 0; i < n; ++i) {
+        if (!lvl.isWalkable(to[i].x, to[i].y)) continue;
+        live[i] = true;
+        ct[i]   = clusterOf(to[i]);
+        bfs(ct[i], to[i], &s.toDist[std::size_t(i) * CELLS]);
+        if (ct[i] == cf) {
+            const Vec2i o = origin(cf);
+            const std::uint16_t d = s.fromDist[std::size_t((to[i].x - o.x) | (to[i].y - o.y) << 4)];
+            if (d != NO_PATH) out[i] = d;
+        }
+    }
+    if (std::find(live, live + n, true) == live + n) return;
+
+    auto h = [&](std::uint32_t node) {
+        const Vec2i t = tileOf(int(node / MAX_ENTRANCES), int(node % MAX_ENTRANCES));
+        std::uint32_t best = UNREACHABLE;
+        for (int i = 0; i < n; ++i)
+            if (live[i]) best = std::min(best, std::uint32_t(std::abs(t.x - to[i].x) + std::abs(t.y - to[i].y)));
+        return best;
+    };
+    auto relax = [&](std::uint32_t node, std::uint32_t g) {
+        if (s.seen[node] == s.stamp && s.g[node] <= g) return;
+        s.seen[node] = s.stamp;
+        s.g[node]    = g;
+        s.open.push_back({G_WEIGHT * g + H_WEIGHT * h(node), g, node});
+        std::push_heap(s.open.begin(), s.open.end(), later);
+    };
+
+    const Cluster& start = clusters_[std::size_t(cf)];
+    for (int e = 0; e < start.first[4]; ++e) {
+        const std::uint16_t d = s.fromDist[start.at[std::size_t(e)]];
+        if (d != NO_PATH) relax(std::uint32_t(cf) * MAX_ENTRANCES + std::uint32_t(e), d);
+    }
+
+    while (!s.open.empty()) {
+        std::pop_heap(s.open.begin(), s.open.end(), later);
+        const Search::Open cur = s.open.back();
+        s.open.pop_back();
+        if (s.done[cur.node] == s.stamp) continue;
+        s.done[cur.node] = s.stamp;
+
+        // done once the estimate of what is left reaches every answer
+        std::uint64_t bound = 0;
+        for (int i = 0; i < n; ++i)
+            if (live[i]) bound = std::max<std::uint64_t>(bound, out[i]);
+        if (cur.f >= G_WEIGHT * bound) break;
+
+        const int      c  = int(cur.node / MAX_ENTRANCES);
+        const int      e  = int(cur.node % MAX_ENTRANCES);
+        const Cluster& cl = clusters_[std::size_t(c)];
+        const std::uint8_t at = cl.at[std::size_t(e)];
+
+        for (int i = 0; i < n; ++i)
+            if (live[i] && ct[i] == c) {
+                const std::uint16_t d = s.toDist[std::size_t(i) * CELLS + at];
+                if (d != NO_PATH) out[i] = std::min(out[i], cur.g + d);
+            }
+
+        const std::uint32_t base = std::uint32_t(c) * MAX_ENTRANCES;
+        for (int j = 0; j < cl.first[4]; ++j) {
+            const std::uint16_t d = cl.dist[std::size_t(e)][std::size_t(j)];
+            if (j != e && d != NO_PATH) relax(base + std::uint32_t(j), cur.g + d);
+        }
+
+        // one step over the border, onto the same run seen from the other side
+        int side = Left;
+        while (e >= cl.first[std::size_t(side) + 1]) ++side;
+        const int run = e - cl.first[std::size_t(side)];
+        const int nc  = side == Left ? c - 1 : side == Right ? c + 1 : side == Up ? c - cw_ : c + cw_;
+        const int opp = side ^ 1;
+        relax(std::uint32_t(nc) * MAX_ENTRANCES + clusters_[std::size_t(nc)].first[std::size_t(opp)] + std::uint32_t(run),
+              cur.g + 1);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Geometry.hpp"
+
+class Level;
+
+// hierarchical tile distances (HPA*) for mazes too big for Level's
+// all-pairs table.
+// The maze is cut into CLUSTER x CLUSTER tile clusters. Along each border
+// between two clusters, every run of tiles open on both sides is one
+// entrance, kept as the run's middle tile on either side; the distances
+// between the entrances of a cluster, staying inside it, are cached. A
+// query searches that entrance graph (A*, entrances linked across borders
+// by one step) from the start's cluster and refines both ends with a BFS
+// inside their own cluster, so it touches a few hundred entrances instead
+// of every tile. Paths cross borders only at entrances and the search leans
+// on its heuristic, so distances can be a few tiles longer than the
+// shortest path; they are never shorter.
+// Same 4-neighbourhood as the all-pairs table: walkable tiles, no tunnels.
+class PathHierarchy {
+public:
+    static constexpr int           CLUSTER       = 16;
+    static constexpr int           MAX_ENTRANCES = 4 * (CLUSTER / 2);  // runs on a side are a wall apart
+    static constexpr std::uint32_t UNREACHABLE   = 0xFFFFFFFF;
+
+    void build(const Level& lvl);
+
+    // after the walkability of tile changed: rebuilds the clusters that
+    // contain it or share a border run with it, nothing else
+    void invalidate(const Level& lvl, Vec2i tile);
+
+    bool        empty()     const { return clusters_.empty(); }
+    std::size_t clusters()  const { return clusters_.size(); }
+    std::size_t entrances() const;
+
+    // out[i] = distance from `from` to to[i], for n <= 4 tiles next to each
+    // other (a ghost's candidate moves); one search answers all of them.
+    // Safe to call from several threads at once.
+    void distances(const Level& lvl, Vec2i from, const Vec2i* to, int n, std::uint32_t* out) const;
+
+private:
+    static constexpr std::uint16_t NO_PATH = 0xFFFF;
+    static constexpr int           CELLS   = CLUSTER * CLUSTER;
+
+    struct Cluster {
+        std::array<std::uint64_t, CELLS / 64> open{};   // walkable tiles, bit x | y << 4
+        std::array<std::uint8_t, 5>  first{};      // side s owns entrances [first[s], first[s+1])
+        std::array<std::uint8_t, MAX_ENTRANCES> at{};   // local tile, x | y << 4
+        std::array<std::array<std::uint16_t, MAX_ENTRANCES>, MAX_ENTRANCES> dist{};
+    };
+    enum Side : int { Left, Right, Up, Down };
+
+    int  clusterOf(Vec2i t) const { return (t.y / CLUSTER) * cw_ + t.x / CLUSTER; }
+    Vec2i origin(int c) const { return {c % cw_ * CLUSTER, c / cw_ * CLUSTER}; }
+    Vec2i tileOf(int c, int e) const
+    {
+        const Vec2i o = origin(c);
+        const std::uint8_t a = clusters_[std::size_t(c)].at[std::size_t(e)];
+        return {o.x + (a & 15), o.y + (a >> 4)};
+    }
+    void buildCluster(const Level& lvl, int c);
+    void bfs(int c, Vec2i from, std::uint16_t* dist) const;   // CELLS entries
+
+    int                  w_{0}, h_{0};
+    int                  cw_{0}, ch_{0};      // clusters across and down
+    std::vector<Cluster> clusters_;
+};
@@ -1,42 +1,42 @@
 #pragma once
-#include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
-#include <functional>
-#include <vector>
-
 #include "Constants.hpp"
+#include "Geometry.hpp"
 #include "Level.hpp"
+#include "Movement.hpp"
 
 class Player {
 public:
-    using ScoreFn = std::function<void(unsigned)>;
+    // everything update() reads or writes, for snapshots
+    struct State {
+        Fixed2 pos;
+        float mouthPhase;
+        Dir   curDir, nextDir, lastDir;
+        bool  onTeleport;
+    };
 
-    explicit Player(ScoreFn);
-    void handleInput();
-    void update(Level&);
-    void draw(sf::RenderTarget&) const;
+    explicit Player(Fixed2 start);
+    void setInput(Dir d) { if (d != Dir::None) nextDir_ = d; }
+    bool update(Level&);                  // true if a pellet was eaten
+    void move(const Level&);              // update() without the pellet, e.g. for a ghost avatar
     void reset();
-    sf::Vector2f position() const { return sprite_.getPosition(); }
+    Fixed2 position()  const { return pos_; }
+    Dir   facing()     const { return lastDir_; }
+    float mouthPhase() const { return mouthPhase_; }
 
-private:
-    enum class Dir { None, Left, Right, Up, Down };
-    sf::Vector2f dirVec(Dir) const;
-    bool canMove(const Level&, const sf::Vector2f&) const;
+    State save() const { return {pos_, mouthPhase_, curDir_, nextDir_, lastDir_, onTeleport_}; }
+    void  restore(const State& s)
+    {
+        pos_ = s.pos; mouthPhase_ = s.mouthPhase;
+        curDir_ = s.curDir; nextDir_ = s.nextDir; lastDir_ = s.lastDir;
+        onTeleport_ = s.onTeleport;
+    }
 
-    // sprite and moving
-    sf::CircleShape sprite_;
+private:
+    Fixed2 pos_;
+    Fixed2 start_;
     Dir  curDir_{Dir::None};
     Dir  nextDir_{Dir::None};
     Dir  lastDir_{Dir::Right};
     float mouthPhase_{0.f};
-
-    // munch1/munch2 sound
-    static const sf::SoundBuffer& munchBuf(int id);
-    int  nextId_{0};
-    static constexpr int SLOTS = 8;
-    std::vector<sf::Sound> pool_;
-
-    // score
-    ScoreFn addScore_;
     bool onTeleport_ = false;
 };
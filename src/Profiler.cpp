@@ -0,0 +1,83 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cstdio>
+
+const char* phaseName(Phase p)
+{
+    static const char* const names[PHASES] = {
+        "events", "input", "player", "ghosts", "collision",
+        "level draw", "entity draw", "hud", "display"};
+    return p < Phase::Count ? names[int(p)] : "?";
+}
+
+Profiler& Profiler::get()
+{
+    static Profiler instance;
+    return instance;
+}
+
+Profiler::Profiler()
+: origin_(now())
+{
+}
+
+void Profiler::record(Phase p, std::uint64_t begin, std::uint64_t end)
+{
+    // each thread owns one ring for its lifetime, so every ring stays SPSC
+    thread_local int slot = threads_.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= MAX_THREADS || !rings_[slot].push({begin, end, p, std::uint8_t(slot)}))
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Profiler::collect()
+{
+    char line[160];
+    PhaseSample s;
+    for (auto& ring : rings_) {
+        while (ring.pop(s)) {
+            const int p = int(s.phase);
+            window_[p][count_[p]++ % WINDOW] = float(s.end - s.begin) * 1e-3f;
+
+            if (!trace_.is_open()) continue;
+            int n = std::snprintf(line, sizeof line,
+                "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                firstEvent_ ? "\n" : ",\n", phaseName(s.phase), unsigned(s.thread),
+                double(s.begin - origin_) * 1e-3, double(s.end - s.begin) * 1e-3);
+            trace_.write(line, n);
+            firstEvent_ = false;
+        }
+    }
+}
+
+Profiler::Stats Profiler::stats(Phase p)
+{
+    const int n = std::min(count_[int(p)], WINDOW);
+    if (n == 0) return {0, 0, 0};
+    std::copy_n(window_[int(p)].begin(), n, scratch_.begin());
+    auto at = [&](double q) {
+        auto k = scratch_.begin() + std::min(n - 1, int(q * n));
+        std::nth_element(scratch_.begin(), k, scratch_.begin() + n);
+        return double(*k);
+    };
+    double p50 = at(0.50);
+    double p99 = at(0.99);
+    return {p50, p99, n};
+}
+
+bool Profiler::openTrace(const std::string& path)
+{
+    closeTrace();
+    trace_.open(path, std::ios::trunc);
+    if (!trace_) return false;
+    trace_ << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    firstEvent_ = true;
+    return true;
+}
+
+void Profiler::closeTrace()
+{
+    if (!trace_.is_open()) return;
+    collect();
+    trace_ << "\n]}\n";
+    trace_.close();
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "SpscRing.hpp"
+
+// per-phase frame timers.
+// Scoped timers push (phase, begin, end) samples into one lock-free ring per
+// thread; the frame loop drains them once per frame into a sliding window
+// for p50/p99 and, when tracing, into a Chrome trace-event JSON file
+// (chrome://tracing, Perfetto). Building without PACMAN_PROFILE turns
+// PROFILE_SCOPE into nothing, so the timers cost nothing at all.
+enum class Phase : std::uint8_t {
+    Events, Input, Player, Ghosts, Collision, LevelDraw, EntityDraw, Hud, Display, Count
+};
+inline constexpr int PHASES = int(Phase::Count);
+const char* phaseName(Phase p);
+
+struct PhaseSample {
+    std::uint64_t begin, end;     // ns, steady clock
+    Phase         phase;
+    std::uint8_t  thread;
+};
+
+class Profiler {
+public:
+    static constexpr int MAX_THREADS = 4;
+    static constexpr int RING        = 4096;     // samples in flight per thread
+    static constexpr int WINDOW      = 256;      // samples per phase for percentiles
+
+    struct Stats { double p50us, p99us; int samples; };
+
+    static Profiler& get();
+    static std::uint64_t now()
+    {
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    void setEnabled(bool on) { enabled_.store(on, std::memory_order_relaxed); }
+
+    // producer side, any thread (up to MAX_THREADS distinct ones)
+    void record(Phase p, std::uint64_t begin, std::uint64_t end);
+
+    // consumer side, one thread
+    void  collect();                       // drain every ring
+    Stats stats(Phase p);                  // over the last WINDOW samples
+    bool  openTrace(const std::string& path);
+    void  closeTrace();
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    Profiler();
+    ~Profiler() { closeTrace(); }
+
+    std::atomic<bool>                             enabled_{false};
+    std::atomic<int>                              threads_{0};
+    std::atomic<std::uint64_t>                    dropped_{0};
+    std::array<SpscRing<PhaseSample, RING>, MAX_THREADS> rings_;
+
+    std::uint64_t origin_;
+    std::array<std::array<float, WINDOW>, PHASES> window_{};   // durations in us
+    std::array<int, PHASES>                       count_{};
+    std::array<float, WINDOW>                     scratch_{};
+
+    std::ofstream trace_;
+    bool          firstEvent_{true};
+};
+
+#ifdef PACMAN_PROFILE
+class ScopedPhase {
+public:
+    explicit ScopedPhase(Phase p) : phase_(p), begin_(Profiler::get().enabled() ? Profiler::now() : 0) {}
+    ~ScopedPhase() { if (begin_) Profiler::get().record(phase_, begin_, Profiler::now()); }
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    Phase         phase_;
+    std::uint64_t begin_;
+};
+
+#   define PROFILE_CAT_(a, b) a##b
+#   define PROFILE_CAT(a, b)  PROFILE_CAT_(a, b)
+#   define PROFILE_SCOPE(phase) ScopedPhase PROFILE_CAT(profileScope_, __LINE__)(phase)
+#else
+#   define PROFILE_SCOPE(phase) ((void)0)
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// tiny 64-bit generator (SplitMix64), usable with <random> and std::shuffle;
+// the whole state is one word so it can live in SoA buffers and snapshots
+struct SplitMix64 {
+    using result_type = std::uint64_t;
+
+    std::uint64_t state{0};
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+
+// portable draws: std::shuffle and the <random> distributions are not
+// specified bit-for-bit, so replays use these instead
+
+template<class Rng>
+std::uint32_t randomBelow(Rng& rng, std::uint32_t n)
+{
+    return std::uint32_t(((rng() >> 32) * n) >> 32);
+}
+
+// true with probability num/den
+template<class Rng>
+bool randomChance(Rng& rng, std::uint32_t num, std::uint32_t den)
+{
+    return randomBelow(rng, den) < num;
+}
+
+template<class Rng, class T, std::size_t N>
+void shuffleArray(Rng& rng, T (&a)[N])
+{
+    for (std::size_t i = N - 1; i > 0; --i) {
+        std::size_t j = randomBelow(rng, std::uint32_t(i + 1));
+        T t = a[i]; a[i] = a[j]; a[j] = t;
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <SFML/Config.hpp>
+
+// SFML 2.x / 3.x API differences
+#if SFML_VERSION_MAJOR >= 3
+#   define TEXT_CTOR(font, str) font, str
+#   define FONT_OPEN(font, file) font.openFromFile(file)
+#   define FONT_OPEN_MEM(font, data, size) font.openFromMemory(data, size)
+#   define RECT_W(r) r.size.x
+#   define RECT_H(r) r.size.y
+#   define RENDER_TEXTURE_CREATE(rt, w, h) rt.resize({w, h})
+#   define IMAGE_CREATE(img, w, h, pixels) img.resize({w, h}, pixels)
+#else
+#   define TEXT_CTOR(font, str) str, font
+#   define FONT_OPEN(font, file) font.loadFromFile(file)
+#   define FONT_OPEN_MEM(font, data, size) font.loadFromMemory(data, size)
+#   define RECT_W(r) r.width
+#   define RECT_H(r) r.height
+#   define RENDER_TEXTURE_CREATE(rt, w, h) rt.create(w, h)
+#   define IMAGE_CREATE(img, w, h, pixels) img.create(w, h, pixels)
+#endif
@@ -0,0 +1,315 @@
+#include "ShmEnv.hpp"
+#include "Movement.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#if !defined(_WIN32)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+#if defined(__linux__)
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#endif
+
+namespace {
+
+// polls before sleeping, a few tens of microseconds: longer than a step
+// round trip between two busy processes. Not on a single core, where
+// spinning only keeps the other side from running.
+constexpr int SPIN = 2000;
+
+constexpr std::uint32_t align64(std::uint32_t n) { return (n + 63) & ~63u; }
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// sleeps while w still holds v, at most 100 ms so a vanished peer is noticed
+void futexWait(std::atomic<std::uint32_t>& w, std::uint32_t v)
+{
+#if defined(__linux__)
+    timespec timeout{0, 100'000'000};
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&w), FUTEX_WAIT, v, &timeout, nullptr, 0);
+#else
+    (void)w; (void)v;
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+}
+
+void futexWake(std::atomic<std::uint32_t>& w)
+{
+#if defined(__linux__)
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&w), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)w;
+#endif
+}
+
+// sets seq and wakes the other side if it sleeps on it. Both this and
+// wait() are seq_cst, so a sleeper either sees the new value or is seen
+void signal(std::atomic<std::uint32_t>& seq, std::atomic<std::uint32_t>& sleepers, std::uint32_t v)
+{
+    seq.store(v);
+    if (sleepers.load()) futexWake(seq);
+}
+
+// until seq reaches target (true) or the segment is closed (false)
+bool wait(std::atomic<std::uint32_t>& seq, std::atomic<std::uint32_t>& sleepers, std::uint32_t target,
+          const std::atomic<std::uint32_t>& closed)
+{
+    static const int spin = std::thread::hardware_concurrency() > 1 ? SPIN : 0;
+    for (int i = 0; i < spin; ++i) {
+        if (std::int32_t(seq.load() - target) >= 0) return true;
+        if (closed.load(std::memory_order_relaxed)) return false;
+        cpuRelax();
+    }
+    for (;;) {
+        sleepers.fetch_add(1);
+        const std::uint32_t v = seq.load();
+        const bool reached = std::int32_t(v - target) >= 0;
+        if (!reached && !closed.load()) futexWait(seq, v);
+        sleepers.fetch_sub(1);
+        if (reached) return true;
+        if (closed.load()) return std::int32_t(seq.load() - target) >= 0;
+    }
+}
+
+std::string shmName(const std::string& name)
+{
+    return !name.empty() && name[0] == '/' ? name : '/' + name;
+}
+
+// maps the segment read-write; creates it with size bytes, else takes
+// its size from it
+std::uint8_t* mapSegment(const std::string& name, std::size_t& bytes, bool create)
+{
+#if defined(_WIN32)
+    (void)name; (void)bytes; (void)create;
+    throw std::runtime_error("shared-memory environments need POSIX shared memory");
+#else
+    const std::string path = shmName(name);
+    if (create) ::shm_unlink(path.c_str());
+    const int fd = ::shm_open(path.c_str(), create ? O_CREAT | O_EXCL | O_RDWR : O_RDWR, 0600);
+    if (fd < 0) throw std::runtime_error("cannot open shared memory " + path);
+    struct stat st{};
+    if (create ? ::ftruncate(fd, off_t(bytes)) != 0 : ::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot size shared memory " + path);
+    }
+    if (!create) bytes = std::size_t(st.st_size);
+    void* p = bytes ? ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (p == MAP_FAILED) throw std::runtime_error("cannot map shared memory " + path);
+    return static_cast<std::uint8_t*>(p);
+#endif
+}
+
+void unmapSegment(std::uint8_t* base, std::size_t bytes)
+{
+#if !defined(_WIN32)
+    if (base) ::munmap(base, bytes);
+#else
+    (void)base; (void)bytes;
+#endif
+}
+
+}
+
+ShmEnv::ShmEnv(const std::string& name, Simulation& sim, int slots)
+: sim_(sim)
+, name_(name)
+{
+    const Level& lvl = sim_.level();
+    const std::uint32_t W = std::uint32_t(lvl.width()), H = std::uint32_t(lvl.height());
+    const std::uint32_t G = std::uint32_t(sim_.ghosts().size());
+    const std::uint32_t ghostOffset = sizeof(shm::Slot);
+    const std::uint32_t planeOffset = align64(ghostOffset + G * 8);
+    const std::uint32_t slotBytes   = align64(planeOffset + shm::PLANES * W * H);
+    slots  = std::max(slots, 1);
+    bytes_ = sizeof(shm::Header) + std::size_t(slots) * slotBytes;
+    base_  = mapSegment(name_, bytes_, true);
+    hdr_   = new (base_) shm::Header{};
+
+    // walls never change, so every slot gets them once
+    for (int k = 0; k < slots; ++k) {
+        std::uint8_t* walls = base_ + sizeof(shm::Header) + std::size_t(k) * slotBytes + planeOffset;
+        for (std::uint32_t y = 0; y < H; ++y)
+            for (std::uint32_t x = 0; x < W; ++x) walls[y * W + x] = lvl.isWall(int(x), int(y));
+    }
+    pelletState_.resize(std::size_t(slots));
+
+    hdr_->version     = shm::VERSION;
+    hdr_->width       = W;
+    hdr_->height      = H;
+    hdr_->slots       = std::uint32_t(slots);
+    hdr_->ghosts      = G;
+    hdr_->tileUnits   = TILE_FX;
+    hdr_->slotOffset  = sizeof(shm::Header);
+    hdr_->slotBytes   = slotBytes;
+    hdr_->ghostOffset = ghostOffset;
+    hdr_->planeOffset = planeOffset;
+    // an agent that finds the magic finds the rest
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr_->magic = shm::MAGIC;
+}
+
+ShmEnv::~ShmEnv()
+{
+    close();
+    unmapSegment(base_, bytes_);
+#if !defined(_WIN32)
+    ::shm_unlink(shmName(name_).c_str());
+#endif
+}
+
+void ShmEnv::close()
+{
+    if (!hdr_ || hdr_->closed.exchange(1)) return;
+    futexWake(hdr_->obsSeq);
+    futexWake(hdr_->actSeq);
+}
+
+void ShmEnv::writePellets(std::size_t slot, std::uint8_t* plane)
+{
+    const Level& lvl = sim_.level();
+    const int W = lvl.width();
+    const std::vector<std::uint32_t>& eaten = lvl.eatenSinceReset();
+    PelletState& st = pelletState_[slot];
+    if (st.epoch != lvl.pelletEpoch() || st.eaten > eaten.size()) {
+        for (int y = 0; y < lvl.height(); ++y)
+            for (int x = 0; x < W; ++x) plane[y * W + x] = lvl.hasPellet(x, y);
+    } else {
+        // only what was eaten since this slot was last written
+        for (std::size_t i = st.eaten; i < eaten.size(); ++i) {
+            const Vec2i t = lvl.tileOfBit(eaten[i]);
+            plane[t.y * W + t.x] = 0;
+        }
+    }
+    st.epoch = lvl.pelletEpoch();
+    st.eaten = eaten.size();
+}
+
+// everything but the walls, in place; the previous occupant of the slot
+// is cleared from the occupancy planes by its own positions
+void ShmEnv::publish()
+{
+    const std::uint32_t W = hdr_->width, H = hdr_->height, area = W * H;
+    const std::size_t   k = published_ % hdr_->slots;
+    std::uint8_t*  base   = base_ + hdr_->slotOffset + k * hdr_->slotBytes;
+    shm::Slot&     s      = *reinterpret_cast<shm::Slot*>(base);
+    std::int32_t*  ghosts = reinterpret_cast<std::int32_t*>(base + hdr_->ghostOffset);
+    std::uint8_t*  planes = base + hdr_->planeOffset;
+    auto cell = [&](std::int32_t x, std::int32_t y) {
+        const std::int32_t tx = std::clamp(x / TILE_FX, 0, std::int32_t(W) - 1);
+        const std::int32_t ty = std::clamp(y / TILE_FX, 0, std::int32_t(H) - 1);
+        return std::size_t(ty) * W + std::size_t(tx);
+    };
+
+    std::uint8_t* player = planes + shm::PLAYER * area;
+    std::uint8_t* crowd  = planes + shm::GHOSTS * area;
+    player[cell(s.playerX, s.playerY)] = 0;
+    for (std::uint32_t i = 0; i < hdr_->ghosts; ++i) crowd[cell(ghosts[2 * i], ghosts[2 * i + 1])] = 0;
+
+    const Fixed2 p = sim_.player().position();
+    s.tick    = sim_.tick();
+    s.score   = sim_.score();
+    s.lives   = sim_.lives();
+    s.done    = sim_.finished();
+    s.action  = 0;
+    s.playerX = p.x;
+    s.playerY = p.y;
+    player[cell(p.x, p.y)] = 1;
+    for (std::uint32_t i = 0; i < hdr_->ghosts; ++i) {
+        const Fixed2 g = sim_.ghosts()[i].position();
+        ghosts[2 * i]     = g.x;
+        ghosts[2 * i + 1] = g.y;
+        std::uint8_t& c = crowd[cell(g.x, g.y)];
+        if (c < 255) ++c;
+    }
+    writePellets(k, planes + shm::PELLETS * area);
+
+    signal(hdr_->obsSeq, hdr_->obsSleepers, ++published_);
+}
+
+bool ShmEnv::step()
+{
+    publish();
+    if (!wait(hdr_->actSeq, hdr_->actSleepers, published_, hdr_->closed)) return false;
+
+    const shm::Slot& s = *reinterpret_cast<const shm::Slot*>(
+        base_ + hdr_->slotOffset + (published_ - 1) % hdr_->slots * hdr_->slotBytes);
+    Input in = inputlog::unpack(s.action);
+    if (in.dir > Dir::Down) in.dir = Dir::None;
+    in.restart = sim_.finished();
+    sim_.step(in);
+    return true;
+}
+
+ShmAgent::ShmAgent(const std::string& name)
+{
+    base_ = mapSegment(name, bytes_, false);
+    hdr_  = reinterpret_cast<shm::Header*>(base_);
+    const bool ok = bytes_ >= sizeof(shm::Header) && hdr_->magic == shm::MAGIC && hdr_->version == shm::VERSION
+                 && bytes_ >= std::size_t(hdr_->slotOffset) + std::size_t(hdr_->slots) * hdr_->slotBytes;
+    if (!ok) {
+        unmapSegment(base_, bytes_);
+        base_ = nullptr;
+        throw std::runtime_error("shared memory " + name + " is not a ready environment");
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    seen_ = hdr_->actSeq.load();
+}
+
+ShmAgent::~ShmAgent()
+{
+    close();
+    unmapSegment(base_, bytes_);
+}
+
+void ShmAgent::close()
+{
+    if (!hdr_ || hdr_->closed.exchange(1)) return;
+    futexWake(hdr_->obsSeq);
+    futexWake(hdr_->actSeq);
+}
+
+shm::Slot* ShmAgent::slot(std::uint32_t k) const
+{
+    return reinterpret_cast<shm::Slot*>(base_ + hdr_->slotOffset + std::size_t(k % hdr_->slots) * hdr_->slotBytes);
+}
+
+const shm::Slot* ShmAgent::observe()
+{
+    if (!wait(hdr_->obsSeq, hdr_->obsSleepers, seen_ + 1, hdr_->closed)) return nullptr;
+    return slot(seen_++);
+}
+
+const std::int32_t* ShmAgent::ghosts(const shm::Slot& s) const
+{
+    return reinterpret_cast<const std::int32_t*>(reinterpret_cast<const std::uint8_t*>(&s) + hdr_->ghostOffset);
+}
+
+const std::uint8_t* ShmAgent::plane(const shm::Slot& s, shm::Plane p) const
+{
+    return reinterpret_cast<const std::uint8_t*>(&s) + hdr_->planeOffset + std::size_t(p) * hdr_->width * hdr_->height;
+}
+
+void ShmAgent::act(const Input& in)
+{
+    slot(seen_ - 1)->action = inputlog::pack(in);
+    signal(hdr_->actSeq, hdr_->actSleepers, seen_);
+}
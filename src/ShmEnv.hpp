@@ -0,0 +1,141 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "InputLog.hpp"
+#include "Simulation.hpp"
+
+// a game played by another process through POSIX shared memory. The
+// segment holds a header and a ring of slots. Each slot is one tick's
+// observation, written in place: a few counters, the entity positions and
+// four uint8 planes of height x width tiles. The agent's action for that
+// tick goes back in the same slot. Either side can map the planes as
+// arrays and read them with no copy; an agent may keep the last `slots`
+// observations without copying, e.g. for frame stacking.
+//
+// Observation k goes to slot k % slots. The env publishes it by setting
+// obsSeq to k + 1; the agent answers by writing the slot's action and
+// setting actSeq to k + 1. Each side spins briefly on the other's counter
+// and then sleeps on it as a futex, which the other side wakes only when
+// someone sleeps. A game that ended restarts on the next tick, whatever
+// the action.
+//
+// All offsets and sizes are in the header, so clients in other languages
+// (tools/pacman_shm.py) need no more than this layout.
+namespace shm {
+
+inline constexpr std::uint32_t MAGIC   = 0x4F4D4350;   // "PCMO"
+inline constexpr std::uint32_t VERSION = 1;
+
+enum Plane : std::uint32_t {
+    WALLS,      // 1 where a wall is
+    PELLETS,    // 1 where a pellet is
+    PLAYER,     // 1 on the player's tile
+    GHOSTS,     // ghosts on the tile, up to 255
+    PLANES
+};
+
+struct Header {
+    std::uint32_t magic, version;
+    std::uint32_t width, height;       // planes are [height][width], row-major
+    std::uint32_t slots;               // ring length
+    std::uint32_t ghosts;              // entries in each slot's ghost positions
+    std::uint32_t tileUnits;           // position units per tile (TILE_FX)
+    std::uint32_t slotOffset;          // first slot, from the start of the segment
+    std::uint32_t slotBytes;           // stride of the ring
+    std::uint32_t ghostOffset;         // int32 x, y per ghost, within a slot
+    std::uint32_t planeOffset;         // PLANES planes, within a slot
+    std::uint32_t reserved[5];
+
+    alignas(64) std::atomic<std::uint32_t> obsSeq;    // observations published; futex word
+    std::atomic<std::uint32_t>             obsSleepers;
+    alignas(64) std::atomic<std::uint32_t> actSeq;    // actions answered; futex word
+    std::atomic<std::uint32_t>             actSleepers;
+    alignas(64) std::atomic<std::uint32_t> closed;    // either side left
+};
+
+// start of every slot; ghost positions and planes follow at the offsets
+// the header gives
+struct Slot {
+    std::uint64_t tick;
+    std::uint32_t score;
+    std::int32_t  lives;
+    std::uint8_t  done;                // the game ended on this tick
+    std::uint8_t  action;              // agent: inputlog::pack(Input), restart is ignored
+    std::uint8_t  reserved[6];
+    std::int32_t  playerX, playerY;
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(sizeof(Header) == 256 && sizeof(Slot) == 32);
+
+}
+
+// the game's end: owns the segment and steps a Simulation for the agent
+class ShmEnv {
+public:
+    static constexpr int DEFAULT_SLOTS = 8;
+
+    // creates the segment /name (replacing a stale one); throws on failure
+    ShmEnv(const std::string& name, Simulation& sim, int slots = DEFAULT_SLOTS);
+    ~ShmEnv();
+
+    ShmEnv(const ShmEnv&) = delete;
+    ShmEnv& operator=(const ShmEnv&) = delete;
+
+    // publishes the current state, waits for the action and steps; false
+    // once the agent has left
+    bool step();
+    void close();                      // tells the agent the env is gone
+
+    std::uint64_t steps() const { return published_; }
+
+private:
+    void publish();
+    void writePellets(std::size_t slot, std::uint8_t* plane);
+
+    Simulation&     sim_;
+    std::string     name_;
+    std::size_t     bytes_{0};
+    std::uint8_t*   base_{nullptr};
+    shm::Header*    hdr_{nullptr};
+    std::uint32_t   published_{0};
+
+    // what each slot's pellet plane shows, to update it from the level's
+    // change log rather than rebuild it
+    struct PelletState { std::uint32_t epoch{PelletBoard::NO_EPOCH}; std::size_t eaten{0}; };
+    std::vector<PelletState> pelletState_;
+};
+
+// the agent's end, for agents in C++ and as the reference for other
+// languages
+class ShmAgent {
+public:
+    // maps /name, created by an ShmEnv; throws if it is missing or does
+    // not match this build's layout
+    explicit ShmAgent(const std::string& name);
+    ~ShmAgent();
+
+    ShmAgent(const ShmAgent&) = delete;
+    ShmAgent& operator=(const ShmAgent&) = delete;
+
+    const shm::Header& header() const { return *hdr_; }
+
+    // the next observation, nullptr once the env is gone
+    const shm::Slot* observe();
+    const std::int32_t* ghosts(const shm::Slot& s) const;    // x, y per ghost
+    const std::uint8_t* plane(const shm::Slot& s, shm::Plane p) const;
+
+    void act(const Input& in);         // answers the last observation
+    void close();
+
+private:
+    shm::Slot* slot(std::uint32_t k) const;
+
+    std::size_t     bytes_{0};
+    std::uint8_t*   base_{nullptr};
+    shm::Header*    hdr_{nullptr};
+    std::uint32_t   seen_{0};          // observations taken
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "Level.hpp"
+#include "Movement.hpp"
+#include "Simulation.hpp"
+
+// what the renderer sees of one tick, copied out on the simulation thread
+// and handed over through a TripleBuffer. Bodies also carry where they were
+// before the tick, so a display running at any rate can draw them part of
+// the way between the two.
+struct SimSnapshot {
+    struct Body {
+        Fixed2        from, to;       // before and after the tick
+        std::uint32_t color;
+
+        // in pixels, alpha 0 at `from` and 1 at `to`; jumps of more than a
+        // tile (tunnels, deaths, rewinds) are not smeared across the maze
+        Vec2 at(float alpha) const
+        {
+            const Vec2 b = toPixels(to);
+            if (std::abs(to.x - from.x) > TILE_FX || std::abs(to.y - from.y) > TILE_FX) return b;
+            const Vec2 a = toPixels(from);
+            return {a.x + (b.x - a.x) * alpha, a.y + (b.y - a.y) * alpha};
+        }
+    };
+
+    std::uint64_t     tick{0};
+    std::uint64_t     dueNs{0};       // steady clock time the tick was run for
+    Body              player{};
+    Dir               facing{Dir::Right};
+    float             mouthPhase{0.f};
+    std::vector<Body> ghosts;
+    PelletBoard       pellets;
+    unsigned          score{0};
+    int               lives{0};
+    bool              levelCleared{false};
+    bool              gameOver{false};
+
+    bool finished() const { return levelCleared || gameOver; }
+
+    // sizes the snapshot for sim, so capturing never allocates
+    void reserve(const Simulation& sim)
+    {
+        ghosts.reserve(sim.ghosts().size());
+        pellets.reserve(sim.level());
+    }
+
+    // positions before a tick, then everything after it
+    void captureBefore(const Simulation& sim)
+    {
+        ghosts.resize(sim.ghosts().size());
+        player.from = sim.player().position();
+        for (std::size_t i = 0; i < ghosts.size(); ++i) ghosts[i].from = sim.ghosts()[i].position();
+    }
+    void captureAfter(const Simulation& sim, std::uint64_t due)
+    {
+        tick         = sim.tick();
+        dueNs        = due;
+        player.to    = sim.player().position();
+        facing       = sim.player().facing();
+        mouthPhase   = sim.player().mouthPhase();
+        for (std::size_t i = 0; i < ghosts.size(); ++i) {
+            ghosts[i].to    = sim.ghosts()[i].position();
+            ghosts[i].color = sim.ghosts()[i].color();
+        }
+        pellets.follow(sim.level());
+        score        = sim.score();
+        lives        = sim.lives();
+        levelCleared = sim.levelCleared();
+        gameOver     = sim.gameOver();
+    }
+};
@@ -0,0 +1,239 @@
+#include "Simulation.hpp"
+#include "GameState.hpp"
+#include "Profiler.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+Simulation::Simulation(const std::string& levelFile, std::uint64_t seed, int ghosts)
+: Simulation(Level::open(levelFile), seed, ghosts)
+{
+}
+
+Simulation::Simulation(Level level, std::uint64_t seed, int ghosts)
+: level_(std::move(level))
+, player_(tileCenter(level_.playerStart()))
+, seed_(seed)
+, rng_{seed}
+{
+    if (ghosts <= 0) ghosts = level_.ghostCount();
+    if (ghosts <= 0) ghosts = GHOSTS;
+    spawnGhosts(ghosts);
+}
+
+// the first GHOSTS start in the ghost house; extra ones take random tiles a
+// body fits on, at least SAFE_TILES steps from the player's start. The draw
+// uses its own generator so the session's stream is untouched. Ghost i
+// behaves as ghostai::kindOf(i); ghosts_ holds them grouped by kind.
+void Simulation::spawnGhosts(int count)
+{
+    constexpr int SAFE_TILES = 8;
+
+    std::vector<Fixed2> starts;
+    for (int i = 0; i < count && i < GHOSTS; ++i)
+        starts.push_back(tileCenter(level_.ghostStart(i)));
+
+    if (count > GHOSTS) {
+        const Vec2i home = level_.playerStart();
+        std::vector<Vec2i> open;
+        for (int y = 0; y < level_.height(); ++y)
+            for (int x = 0; x < level_.width(); ++x)
+                if (std::abs(x - home.x) + std::abs(y - home.y) >= SAFE_TILES
+                    && !level_.isTeleport(x, y) && canOccupy(level_, tileCenter({x, y})))
+                    open.push_back({x, y});
+        if (open.empty())
+            throw std::runtime_error("no room for extra ghosts in this level");
+
+        SplitMix64 spawn{seed_ ^ 0x6A09E667F3BCC909ull};
+        for (int i = GHOSTS; i < count; ++i)
+            starts.push_back(tileCenter(open[randomBelow(spawn, std::uint32_t(open.size()))]));
+    }
+
+    ghosts_.reserve(starts.size());
+    for (int k = 0; k < ghostai::KINDS; ++k) {
+        firstOfKind_[std::size_t(k)] = std::uint32_t(ghosts_.size());
+        for (std::size_t i = std::size_t(k); i < starts.size(); i += ghostai::KINDS)
+            ghosts_.emplace_back(GHOST_COLOR[k], starts[i]);
+    }
+    firstOfKind_[ghostai::KINDS] = std::uint32_t(ghosts_.size());
+}
+
+bool Simulation::playerHit()
+{
+    const Fixed2 p = player_.position();
+    if (collision_ == CollisionMode::BruteForce) {
+        hashStale_ = true;
+        for (auto& g : ghosts_)
+            if (touching(g.position(), p)) return true;
+        return false;
+    }
+
+    // rebuilt after anything that moves every ghost at once, else kept
+    // current ghost by ghost
+    if (hashStale_) {
+        ghostHash_.build(ghosts_.size(), [this](std::size_t i){ return ghosts_[i].position(); });
+        hashStale_ = false;
+    } else {
+        for (std::size_t i = 0; i < ghosts_.size(); ++i)
+            ghostHash_.move(std::uint32_t(i), ghosts_[i].position());
+    }
+    return ghostHash_.anyNear(p, [&](std::uint32_t i){ return touching(ghosts_[i].position(), p); });
+}
+
+void Simulation::restart()
+{
+    level_.resetPellets();
+    player_.reset();
+    for(auto& g:ghosts_) g.reset();
+    hashStale_    = true;
+    score_        = 0;
+    lives_        = START_LIVES;
+    levelCleared_ = false;
+    gameOver_     = false;
+}
+
+std::uint64_t Simulation::tableDecisions() const
+{
+    std::uint64_t n = 0;
+    for (auto& g : ghosts_) n += g.tableHits();
+    return n;
+}
+
+std::uint64_t Simulation::ghostDecisions() const
+{
+    std::uint64_t n = 0;
+    for (auto& g : ghosts_) n += g.decisions();
+    return n;
+}
+
+std::uint64_t Simulation::corridorTurns() const
+{
+    std::uint64_t n = 0;
+    for (auto& g : ghosts_) n += g.corridorTurns();
+    return n;
+}
+
+std::uint64_t Simulation::checksum() const
+{
+    // FNV-1a over every piece of state that affects the future: what
+    // GameState saves, less the player's mouth, which is only drawn.
+    // Fields go in one by one, so struct padding never counts.
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&h](const void* p, std::size_t n){
+        auto* b = static_cast<const unsigned char*>(p);
+        for (std::size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 0x100000001b3ull; }
+    };
+    auto mixPos  = [&mix](Fixed2 p){ mix(&p.x, sizeof p.x); mix(&p.y, sizeof p.y); };
+    auto mixByte = [&mix](std::uint8_t b){ mix(&b, 1); };
+
+    mix(&tick_, sizeof tick_);
+    mix(&score_, sizeof score_);
+    mix(&lives_, sizeof lives_);
+    mixByte(gameOver_);
+    mixByte(levelCleared_);
+    mix(&rng_.state, sizeof rng_.state);
+    const Player::State p = player_.save();
+    mixPos(p.pos);
+    for (Dir d : {p.curDir, p.nextDir, p.lastDir}) mixByte(std::uint8_t(d));
+    mixByte(p.onTeleport);
+    for (auto& g : ghosts_) {
+        const Ghost::State gs = g.save();
+        mixPos(gs.pos);
+        mixByte(std::uint8_t(gs.curDir));
+        mixByte(gs.onTeleport);
+    }
+    mix(level_.pellets(), level_.bitboardWords() * sizeof(std::uint64_t));
+    return h;
+}
+
+// a GameState fits only levels up to MAX_PELLET_WORDS with GHOSTS ghosts
+void Simulation::checkSnapshotable() const
+{
+    if (level_.bitboardWords() > GameState::MAX_PELLET_WORDS)
+        throw std::runtime_error("level too large for a GameState snapshot");
+    if (ghosts_.size() != GHOSTS)
+        throw std::runtime_error("GameState snapshots hold exactly GHOSTS ghosts");
+}
+
+void Simulation::save(GameState& out) const
+{
+    checkSnapshotable();
+    const std::size_t words = level_.bitboardWords();
+
+    out.tick         = tick_;
+    out.rng          = rng_.state;
+    out.score        = score_;
+    out.lives        = lives_;
+    out.gameOver     = gameOver_;
+    out.levelCleared = levelCleared_;
+    out.player       = player_.save();
+    for (int i = 0; i < GHOSTS; ++i) out.ghosts[i] = ghosts_[i].save();
+    std::memcpy(out.pellets, level_.pellets(), words * sizeof(std::uint64_t));
+}
+
+void Simulation::restore(const GameState& in)
+{
+    checkSnapshotable();
+    tick_         = in.tick;
+    rng_.state    = in.rng;
+    score_        = in.score;
+    lives_        = in.lives;
+    gameOver_     = in.gameOver;
+    levelCleared_ = in.levelCleared;
+    player_.restore(in.player);
+    for (int i = 0; i < GHOSTS; ++i) ghosts_[i].restore(in.ghosts[i]);
+    level_.restorePellets(in.pellets);
+    hashStale_    = true;
+}
+
+unsigned Simulation::step(const Input& in)
+{
+    ++tick_;
+    if (finished()) {
+        if (!in.restart) return EV_NONE;
+        restart();
+        return EV_RESTART;
+    }
+
+    unsigned ev = EV_NONE;
+    {
+        PROFILE_SCOPE(Phase::Player);
+        player_.setInput(in.dir);
+        if (player_.update(level_)) {
+            score_ += PELLET_SCORE;
+            ev |= EV_PELLET;
+        }
+    }
+    {
+        // one batch per behaviour, each a loop over one instantiation of
+        // Ghost::update
+        PROFILE_SCOPE(Phase::Ghosts);
+        const ghostai::Hunt hunt{tileOf(player_.position()), player_.facing()};
+        for (int k = 0; k < ghostai::KINDS; ++k)
+            ghostai::withPolicy(ghostai::Kind(k), [&]<class Policy>(Policy) {
+                for (std::uint32_t i = firstOfKind_[std::size_t(k)]; i < firstOfKind_[std::size_t(k) + 1]; ++i)
+                    ghosts_[i].update<Policy>(level_, hunt, rng_);
+            });
+    }
+
+    PROFILE_SCOPE(Phase::Collision);
+    if(playerHit()){
+        lives_--;
+        ev |= EV_DEATH;
+        if(lives_ <= 0){
+            gameOver_ = true;
+            ev |= EV_GAME_OVER;
+        }
+        player_.reset();
+        for(auto& g:ghosts_) g.reset();
+        hashStale_ = true;
+    }
+
+    if (!level_.pelletsRemaining())
+    {
+        levelCleared_ = true;
+        ev |= EV_LEVEL_CLEAR;
+    }
+    return ev;
+}
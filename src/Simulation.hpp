@@ -0,0 +1,110 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Level.hpp"
+#include "Player.hpp"
+#include "Ghost.hpp"
+#include "Random.hpp"
+#include "SpatialHash.hpp"
+
+// per-tick player command
+struct Input {
+    Dir  dir{Dir::None};
+    bool restart{false};      // start a new game once the current one is over
+};
+
+// things that happened during a step, for sound and bookkeeping
+enum SimEvent : unsigned {
+    EV_NONE        = 0,
+    EV_PELLET      = 1u << 0,
+    EV_DEATH       = 1u << 1,
+    EV_GAME_OVER   = 1u << 2,
+    EV_LEVEL_CLEAR = 1u << 3,
+    EV_RESTART     = 1u << 4,
+};
+
+struct GameState;
+
+// how step() finds ghosts touching the player. There is one query per
+// tick, so keeping the hash current costs more than the distance test it
+// saves (see the collision/ benchmarks); it pays off once many bodies are
+// queried per tick.
+enum class CollisionMode : std::uint8_t {
+    BruteForce,    // distance to every ghost
+    SpatialHash,   // only ghosts in the 3x3 tiles around the player
+};
+
+// game rules without window, audio or real-time pacing.
+// A session is a pure function of the seed and the per-tick inputs: all
+// randomness comes from the session's own generator.
+class Simulation {
+public:
+    static constexpr int   TICK_HZ = 60;
+    static constexpr float TICK_DT = 1.f / TICK_HZ;
+
+    static constexpr int      START_LIVES  = 3;
+    static constexpr unsigned PELLET_SCORE = 10;
+
+    // the classic four ghosts, starting where the level says; stress runs
+    // add more on random open tiles
+    static constexpr int  GHOSTS = 4;
+    static constexpr std::uint32_t GHOST_COLOR[GHOSTS] = {
+        0xFF0000FFu, 0x00FFFFFFu, 0xFF00FFFFu, 0xFFA500FFu};   // red, cyan, magenta, orange
+
+    // ghosts == 0 takes the level's "; ghosts N" setting, else GHOSTS
+    explicit Simulation(const std::string& levelFile, std::uint64_t seed = 0, int ghosts = 0);
+    explicit Simulation(Level level, std::uint64_t seed = 0, int ghosts = 0);
+
+    void          setCollisionMode(CollisionMode m) { collision_ = m; }
+    CollisionMode collisionMode() const             { return collision_; }
+
+    unsigned step(const Input& in);   // advance one fixed tick, returns SimEvent bits
+    void     restart();
+
+    std::uint64_t seed()     const { return seed_; }
+    std::uint64_t checksum() const;   // hash of the whole game state, for replay checks
+
+    // copy the whole mutable state in or out; see GameState.hpp.
+    // save() and restore() throw if the level's pellet board is larger than
+    // a GameState holds or the session does not have exactly GHOSTS ghosts.
+    void save(GameState& out) const;
+    void restore(const GameState& in);
+
+    bool finished()     const { return levelCleared_ || gameOver_; }
+    bool levelCleared() const { return levelCleared_; }
+    bool gameOver()     const { return gameOver_; }
+    unsigned score()    const { return score_; }
+    int      lives()    const { return lives_; }
+    std::uint64_t tick() const { return tick_; }
+    std::uint64_t tableDecisions() const;  // ghost decisions answered by the all-pairs table
+    std::uint64_t ghostDecisions() const;  // choices made at junctions
+    std::uint64_t corridorTurns() const;   // tile centres passed without a choice
+
+    const Level&              level()  const { return level_; }
+    const Player&             player() const { return player_; }
+    const std::vector<Ghost>& ghosts() const { return ghosts_; }
+
+private:
+    void spawnGhosts(int count);
+    void checkSnapshotable() const;
+    bool playerHit();
+
+    Level              level_;
+    Player             player_;
+    std::vector<Ghost> ghosts_;            // grouped by ghostai::Kind
+    std::array<std::uint32_t, ghostai::KINDS + 1> firstOfKind_{};
+    CollisionMode      collision_{CollisionMode::BruteForce};
+    SpatialHash        ghostHash_;
+    bool               hashStale_{true};
+
+    std::uint64_t seed_;
+    SplitMix64    rng_;
+
+    unsigned      score_{0};
+    int           lives_{START_LIVES};
+    bool          gameOver_{false};
+    bool          levelCleared_{false};
+    std::uint64_t tick_{0};
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Constants.hpp"
+#include "Geometry.hpp"
+#include "Movement.hpp"
+
+// uniform spatial hash keyed by tile.
+// Every entity sits in an intrusive doubly linked list of the bucket its
+// tile hashes to. Bodies cross a tile every few ticks, so keeping the hash
+// current is one compare per entity plus an O(1) relink for the few that
+// changed bucket, and a query near a point walks only the 3x3 tiles around
+// it. Two bodies can only touch when their tiles are neighbours, since
+// 2*COLL_RADIUS < TILE. Buffers keep their capacity across builds, so
+// steady-state ticks do not allocate.
+class SpatialHash {
+public:
+    static_assert(2 * COLL_RADIUS < TILE, "touching bodies must sit in neighbouring tiles");
+
+    // (re)inserts entities 0..n-1; pos(i) returns the Fixed2 position of i
+    template<class PosFn>
+    void build(std::size_t n, PosFn pos)
+    {
+        std::size_t buckets = 16;
+        while (buckets < 2 * n) buckets <<= 1;
+        mask_ = std::uint32_t(buckets - 1);
+
+        head_.assign(buckets, NONE);
+        next_.resize(n);
+        prev_.resize(n);
+        bucketOf_.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            bucketOf_[i] = bucketAt(pos(i));
+            link(std::uint32_t(i));
+        }
+    }
+
+    std::size_t size() const { return bucketOf_.size(); }
+
+    // entity i is now at p
+    void move(std::uint32_t i, Fixed2 p)
+    {
+        const std::uint32_t b = bucketAt(p);
+        if (b == bucketOf_[i]) return;
+        unlink(i);
+        bucketOf_[i] = b;
+        link(i);
+    }
+
+    // calls f(i) for every entity in the 3x3 tiles around p, plus any that
+    // share their buckets; f returns true to stop early
+    template<class Fn>
+    bool anyNear(Fixed2 p, Fn f) const
+    {
+        if (head_.empty()) return false;
+        const Vec2i t = floorTile(p);
+        std::uint32_t seen[9];
+        int nSeen = 0;
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx) {
+                const std::uint32_t b = bucket({t.x + dx, t.y + dy});
+                bool dup = false;
+                for (int k = 0; k < nSeen; ++k) dup |= seen[k] == b;
+                if (dup) continue;
+                seen[nSeen++] = b;
+                for (std::uint32_t j = head_[b]; j != NONE; j = next_[j])
+                    if (f(j)) return true;
+            }
+        return false;
+    }
+
+private:
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+
+    // tiles by arithmetic shift: flooring is all the hash needs and is
+    // cheaper than tileOf's truncating division
+    static_assert((TILE_FX & (TILE_FX - 1)) == 0, "TILE_FX must be a power of two");
+    static constexpr int TILE_SHIFT = std::countr_zero(unsigned(TILE_FX));
+    static Vec2i floorTile(Fixed2 p) { return {p.x >> TILE_SHIFT, p.y >> TILE_SHIFT}; }
+
+    std::uint32_t bucket(Vec2i t) const
+    {
+        return (std::uint32_t(t.x) * 0x9E3779B1u ^ std::uint32_t(t.y) * 0x85EBCA77u) >> 7 & mask_;
+    }
+    std::uint32_t bucketAt(Fixed2 p) const { return bucket(floorTile(p)); }
+
+    void link(std::uint32_t i)
+    {
+        std::uint32_t& h = head_[bucketOf_[i]];
+        prev_[i] = NONE;
+        next_[i] = h;
+        if (h != NONE) prev_[h] = i;
+        h = i;
+    }
+
+    void unlink(std::uint32_t i)
+    {
+        if (prev_[i] != NONE) next_[prev_[i]] = next_[i];
+        else                  head_[bucketOf_[i]] = next_[i];
+        if (next_[i] != NONE) prev_[next_[i]] = prev_[i];
+    }
+
+    std::uint32_t              mask_{0};
+    std::vector<std::uint32_t> head_;       // first entity per bucket
+    std::vector<std::uint32_t> next_, prev_;
+    std::vector<std::uint32_t> bucketOf_;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// bounded lock-free queue for exactly one producer and one consumer thread.
+// N must be a power of two; push() fails instead of blocking when full.
+template<class T, std::size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    bool push(const T& v)
+    {
+        const std::size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_.load(std::memory_order_acquire) == N) return false;
+        buf_[t & (N - 1)] = v;
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out)
+    {
+        const std::size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_.load(std::memory_order_acquire)) return false;
+        out = buf_[h & (N - 1)];
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t size() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<std::size_t> head_{0};   // consumer side
+    alignas(64) std::atomic<std::size_t> tail_{0};   // producer side
+    alignas(64) T buf_[N]{};
+};
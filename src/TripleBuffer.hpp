@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include <atomic>
+
+// hands the newest of a stream of values from exactly one writer thread to
+// exactly one reader thread; neither side ever waits for the other. The
+// writer fills back() and publish() swaps it with the shared middle slot;
+// the reader's update() swaps the middle slot for front() when something
+// newer was published. Values the reader never got to are overwritten, so
+// slots are reused as they are and should not allocate once warmed up.
+template<class T>
+class TripleBuffer {
+public:
+    // before either thread starts, e.g. to size every slot
+    template<class F>
+    void forEachSlot(F f) { for (T& s : slots_) f(s); }
+
+    // writer side
+    T&   back() { return slots_[back_]; }
+    void publish()
+    {
+        back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // reader side; true when front() changed
+    bool update()
+    {
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH)) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& front() const { return slots_[front_]; }
+
+private:
+    static constexpr unsigned INDEX = 3, FRESH = 4;   // slot index, unread flag
+
+    std::array<T, 3>                  slots_{};
+    alignas(64) std::atomic<unsigned> middle_{1};
+    alignas(64) unsigned              back_{0};       // writer only
+    alignas(64) unsigned              front_{2};      // reader only
+};
@@ -0,0 +1,164 @@
+#include "UdpSocket.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#   include <winsock2.h>
+#   include <ws2tcpip.h>
+    using socklen_t = int;
+#else
+#   include <arpa/inet.h>
+#   include <fcntl.h>
+#   include <netinet/in.h>
+#   include <sys/socket.h>
+#   include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(_WIN32)
+using Native = SOCKET;
+struct WinsockInit {
+    WinsockInit()  { WSADATA d; WSAStartup(MAKEWORD(2, 2), &d); }
+    ~WinsockInit() { WSACleanup(); }
+};
+#else
+using Native = int;
+#endif
+
+Native native(std::intptr_t fd) { return Native(fd); }
+
+sockaddr_in toSockaddr(const NetAddress& a)
+{
+    sockaddr_in s{};
+    s.sin_family      = AF_INET;
+    s.sin_addr.s_addr = htonl(a.ip);
+    s.sin_port        = htons(a.port);
+    return s;
+}
+
+}
+
+bool NetAddress::parse(const std::string& s, NetAddress& out)
+{
+    const std::size_t colon = s.rfind(':');
+    if (colon == std::string::npos) return false;
+    const std::string host = s.substr(0, colon);
+    const long port = std::strtol(s.c_str() + colon + 1, nullptr, 10);
+    if (port <= 0 || port > 65535) return false;
+
+    unsigned b[4];
+    char tail;
+    if (host.empty() || host == "localhost") out.ip = LOOPBACK;
+    else if (std::sscanf(host.c_str(), "%u.%u.%u.%u%c", &b[0], &b[1], &b[2], &b[3], &tail) == 4
+             && b[0] < 256 && b[1] < 256 && b[2] < 256 && b[3] < 256)
+        out.ip = b[0] << 24 | b[1] << 16 | b[2] << 8 | b[3];
+    else return false;
+    out.port = std::uint16_t(port);
+    return true;
+}
+
+std::string NetAddress::str() const
+{
+    return std::to_string(ip >> 24) + '.' + std::to_string(ip >> 16 & 255) + '.'
+         + std::to_string(ip >> 8 & 255) + '.' + std::to_string(ip & 255) + ':' + std::to_string(port);
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+}
+
+void UdpSocket::open(std::uint32_t ip, std::uint16_t port)
+{
+    close();
+#if defined(_WIN32)
+    static WinsockInit winsock;
+#endif
+    const auto fd = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#if defined(_WIN32)
+    if (fd == INVALID_SOCKET) throw std::runtime_error("cannot create a UDP socket");
+    u_long nonBlocking = 1;
+    ioctlsocket(fd, FIONBIO, &nonBlocking);
+#else
+    if (fd < 0) throw std::runtime_error("cannot create a UDP socket");
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    fd_ = std::intptr_t(fd);
+
+    const sockaddr_in a = toSockaddr({ip, port});
+    if (::bind(native(fd_), reinterpret_cast<const sockaddr*>(&a), sizeof a) != 0) {
+        close();
+        throw std::runtime_error("cannot bind UDP port " + std::to_string(port));
+    }
+}
+
+void UdpSocket::close()
+{
+    if (fd_ < 0) return;
+#if defined(_WIN32)
+    ::closesocket(native(fd_));
+#else
+    ::close(native(fd_));
+#endif
+    fd_ = -1;
+    held_.clear();
+}
+
+NetAddress UdpSocket::localAddress() const
+{
+    sockaddr_in a{};
+    socklen_t len = sizeof a;
+    ::getsockname(native(fd_), reinterpret_cast<sockaddr*>(&a), &len);
+    return {ntohl(a.sin_addr.s_addr), ntohs(a.sin_port)};
+}
+
+void UdpSocket::sendNow(const NetAddress& to, const std::uint8_t* data, std::size_t n)
+{
+    const sockaddr_in a = toSockaddr(to);
+    // a full buffer or an unreachable port loses the datagram, as UDP may
+    ::sendto(native(fd_), reinterpret_cast<const char*>(data), int(n), 0,
+             reinterpret_cast<const sockaddr*>(&a), sizeof a);
+}
+
+void UdpSocket::send(const NetAddress& to, const std::uint8_t* data, std::size_t n, std::uint64_t nowMs)
+{
+    if (n > net::MAX_DATAGRAM) throw std::runtime_error("datagram larger than net::MAX_DATAGRAM");
+    bytesSent_ += n;
+    ++datagramsSent_;
+    if (!link_.active()) { sendNow(to, data, n); return; }
+
+    if (link_.loss > 0 && double(rng_() >> 11) * 0x1.0p-53 < link_.loss) return;
+    const std::uint64_t delay = std::uint64_t(link_.latencyMs)
+        + (link_.jitterMs > 0 ? randomBelow(rng_, std::uint32_t(link_.jitterMs) + 1) : 0);
+    Held h{nowMs + delay, to, n, {}};
+    std::memcpy(h.data.data(), data, n);
+    held_.insert(std::upper_bound(held_.begin(), held_.end(), h.due,
+                                  [](std::uint64_t due, const Held& x) { return due < x.due; }), h);
+    flush(nowMs);
+}
+
+void UdpSocket::flush(std::uint64_t nowMs)
+{
+    std::size_t sent = 0;
+    while (sent < held_.size() && held_[sent].due <= nowMs) {
+        sendNow(held_[sent].to, held_[sent].data.data(), held_[sent].n);
+        ++sent;
+    }
+    held_.erase(held_.begin(), held_.begin() + std::ptrdiff_t(sent));
+}
+
+bool UdpSocket::receive(NetAddress& from, std::uint8_t* buf, std::size_t cap, std::size_t& n)
+{
+    sockaddr_in a{};
+    socklen_t len = sizeof a;
+    const auto got = ::recvfrom(native(fd_), reinterpret_cast<char*>(buf), int(cap), 0,
+                                reinterpret_cast<sockaddr*>(&a), &len);
+    if (got < 0) return false;            // nothing waiting, or an ICMP error left behind
+    from = {ntohl(a.sin_addr.s_addr), ntohs(a.sin_port)};
+    n = std::size_t(got);
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "NetCodec.hpp"
+#include "Random.hpp"
+
+// IPv4 endpoint, host byte order
+struct NetAddress {
+    std::uint32_t ip{0};
+    std::uint16_t port{0};
+
+    static constexpr std::uint32_t LOOPBACK = 0x7F000001;
+
+    // "a.b.c.d:port", "localhost:port" or ":port" (loopback)
+    static bool parse(const std::string& s, NetAddress& out);
+    std::string str() const;
+
+    bool operator==(const NetAddress&) const = default;
+};
+
+// what a simulated link does to the datagrams a socket sends, for testing
+// over localhost: drop loss of them, hold the rest back latency plus up to
+// jitter milliseconds, which also reorders them
+struct LinkSim {
+    double loss{0};              // 0..1
+    int    latencyMs{0};
+    int    jitterMs{0};
+
+    bool active() const { return loss > 0 || latencyMs > 0 || jitterMs > 0; }
+};
+
+// non-blocking UDP socket. Times are milliseconds on the caller's clock,
+// which may be simulated; only a LinkSim looks at them.
+class UdpSocket {
+public:
+    UdpSocket() = default;
+    ~UdpSocket();
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // binds ip:port; port 0 takes any free one (see localAddress)
+    void open(std::uint32_t ip = NetAddress::LOOPBACK, std::uint16_t port = 0);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+    NetAddress localAddress() const;
+
+    void setLink(const LinkSim& link, std::uint64_t seed) { link_ = link; rng_.state = seed; }
+
+    void send(const NetAddress& to, const std::uint8_t* data, std::size_t n, std::uint64_t nowMs);
+    void flush(std::uint64_t nowMs);      // sends the held-back datagrams that are due
+    // the next waiting datagram, false when there is none
+    bool receive(NetAddress& from, std::uint8_t* buf, std::size_t cap, std::size_t& n);
+
+    // what send() was given, dropped datagrams included
+    std::uint64_t bytesSent()     const { return bytesSent_; }
+    std::uint64_t datagramsSent() const { return datagramsSent_; }
+
+private:
+    struct Held {
+        std::uint64_t due;
+        NetAddress    to;
+        std::size_t   n;
+        std::array<std::uint8_t, net::MAX_DATAGRAM> data;
+    };
+
+    void sendNow(const NetAddress& to, const std::uint8_t* data, std::size_t n);
+
+    std::intptr_t     fd_{-1};
+    LinkSim           link_;
+    SplitMix64        rng_;
+    std::vector<Held> held_;             // by due time
+    std::uint64_t     bytesSent_{0};
+    std::uint64_t     datagramsSent_{0};
+};
@@ -0,0 +1,126 @@
+#include "WorkerPool.hpp"
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned threads)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    slotMem_ = std::make_unique<Slot[]>(threads);
+    for (unsigned i = 0; i < threads; ++i) slots_.push_back(&slotMem_[i]);
+
+    for (unsigned i = 1; i < threads; ++i)
+        threads_.emplace_back([this, i]{ workerLoop(i); });
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lk(m_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+void WorkerPool::parallelFor(std::size_t n, std::size_t grain, const RangeFn& fn)
+{
+    if (n == 0) return;
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunks = (n + grain - 1) / grain;
+    const unsigned    T      = size();
+
+    if (T == 1 || chunks == 1) {
+        fn(0, n);
+        return;
+    }
+
+    // deal chunks out evenly, then let stealing fix the imbalance
+    for (unsigned i = 0; i < T; ++i)
+        slots_[i]->range.store(pack(std::uint32_t(chunks * i / T),
+                                    std::uint32_t(chunks * (i + 1) / T)),
+                               std::memory_order_relaxed);
+    {
+        std::lock_guard lk(m_);
+        fn_      = &fn;
+        n_       = n;
+        grain_   = grain;
+        running_ = T - 1;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    runSlot(0);
+
+    std::unique_lock lk(m_);
+    done_.wait(lk, [this]{ return running_ == 0; });
+    fn_ = nullptr;
+}
+
+void WorkerPool::workerLoop(unsigned id)
+{
+    std::uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock lk(m_);
+            wake_.wait(lk, [&]{ return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+        runSlot(id);
+        {
+            std::lock_guard lk(m_);
+            if (--running_ == 0) done_.notify_one();
+        }
+    }
+}
+
+void WorkerPool::runSlot(unsigned id)
+{
+    do {
+        std::uint32_t c;
+        while (popOwn(id, c)) {
+            std::size_t b = std::size_t(c) * grain_;
+            (*fn_)(b, std::min(n_, b + grain_));
+        }
+    } while (steal(id));
+}
+
+bool WorkerPool::popOwn(unsigned id, std::uint32_t& chunk)
+{
+    auto& r = slots_[id]->range;
+    std::uint64_t cur = r.load(std::memory_order_acquire);
+    for (;;) {
+        std::uint32_t b = std::uint32_t(cur), e = std::uint32_t(cur >> 32);
+        if (b >= e) return false;
+        if (r.compare_exchange_weak(cur, pack(b + 1, e), std::memory_order_acq_rel)) {
+            chunk = b;
+            return true;
+        }
+    }
+}
+
+bool WorkerPool::steal(unsigned id)
+{
+    const unsigned T = size();
+    for (;;) {
+        // pick the victim with the most chunks left
+        unsigned victim = id;
+        std::uint32_t most = 0;
+        for (unsigned k = 1; k < T; ++k) {
+            unsigned v = (id + k) % T;
+            std::uint64_t cur = slots_[v]->range.load(std::memory_order_relaxed);
+            std::uint32_t b = std::uint32_t(cur), e = std::uint32_t(cur >> 32);
+            if (e > b && e - b > most) { most = e - b; victim = v; }
+        }
+        if (victim == id) return false;
+
+        auto& r = slots_[victim]->range;
+        std::uint64_t cur = r.load(std::memory_order_acquire);
+        std::uint32_t b = std::uint32_t(cur), e = std::uint32_t(cur >> 32);
+        if (b >= e) continue;
+        std::uint32_t mid = b + (e - b) / 2;         // a single chunk is taken whole
+        if (r.compare_exchange_strong(cur, pack(b, mid), std::memory_order_acq_rel)) {
+            slots_[id]->range.store(pack(mid, e), std::memory_order_release);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads running parallel-for jobs with work stealing:
+// every worker starts on its own contiguous share of the chunks and, once it
+// runs dry, steals the upper half of the fullest-looking victim's range
+class WorkerPool {
+public:
+    using RangeFn = std::function<void(std::size_t begin, std::size_t end)>;
+
+    explicit WorkerPool(unsigned threads = 0);   // 0 = hardware concurrency
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned size() const { return unsigned(slots_.size()); }
+
+    // calls fn on [0,n) in chunks of at most grain items; blocks until done.
+    // The calling thread works as slot 0.
+    void parallelFor(std::size_t n, std::size_t grain, const RangeFn& fn);
+
+private:
+    // [begin,end) chunk range packed into one word so owner pops and thief
+    // steals are single CAS operations; padded to avoid false sharing
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> range{0};
+    };
+
+    static std::uint64_t pack(std::uint32_t b, std::uint32_t e) { return (std::uint64_t(e) << 32) | b; }
+
+    void workerLoop(unsigned id);
+    void runSlot(unsigned id);
+    bool popOwn(unsigned id, std::uint32_t& chunk);
+    bool steal(unsigned id);
+
+    std::unique_ptr<Slot[]>  slotMem_;
+    std::vector<Slot*>       slots_;
+    std::vector<std::thread> threads_;
+
+    // current job
+    const RangeFn* fn_{nullptr};
+    std::size_t    n_{0}, grain_{1};
+
+    std::mutex              m_;
+    std::condition_variable wake_, done_;
+    std::uint64_t           generation_{0};
+    unsigned                running_{0};
+    bool                    stop_{false};
+};
@@ -1,5 +1,41 @@
 #include "Game.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
-int main() {
-    Game().run();
-}
\ No newline at end of file
+// usage: PacMan [--seed S] [--level NAME|FILE] [--ghosts N] [--record LOG | --replay LOG] [--uncapped]
+//               [--capture OUT.y4m|DIR [--frames N]] [--trace JSON]
+int main(int argc, char** argv) {
+    GameOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--seed") && i + 1 < argc)
+            opts.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--record") && i + 1 < argc)
+            opts.record = argv[++i];
+        else if (!std::strcmp(argv[i], "--replay") && i + 1 < argc)
+            opts.replay = argv[++i];
+        else if (!std::strcmp(argv[i], "--level") && i + 1 < argc)
+            opts.level = argv[++i];
+        else if (!std::strcmp(argv[i], "--ghosts") && i + 1 < argc)
+            opts.ghosts = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc)
+            opts.trace = argv[++i];
+        else if (!std::strcmp(argv[i], "--capture") && i + 1 < argc)
+            opts.capture = argv[++i];
+        else if (!std::strcmp(argv[i], "--frames") && i + 1 < argc)
+            opts.frames = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--uncapped"))
+            opts.uncapped = true;
+        else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--seed S] [--level NAME|FILE] [--ghosts N] [--record LOG | --replay LOG] [--uncapped]"
+                         " [--capture OUT.y4m|DIR [--frames N]] [--trace JSON]\n";
+            return 1;
+        }
+    }
+
+    AssetManager assets;            // starts decoding everything in parallel
+    Game game(assets, opts);
+    assets.report(std::clog);
+    game.run();
+}
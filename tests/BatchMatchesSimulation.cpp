@@ -0,0 +1,81 @@
+#include "BatchEnv.hpp"
+#include "Random.hpp"
+#include "Movement.hpp"
+#include "Simulation.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+// a one-env BatchEnv must play the same game as a Simulation: same player,
+// ghosts, score and lives after every tick, until the game ends (the batch
+// restarts within a tick, the Simulation on the next one). BatchEnv seeds
+// env e with the e-th draw of SplitMix64{seed}, so the Simulation gets the
+// first draw. Every ghost must also stay on a spot a body fits on; the
+// dead-end maze checks that ghosts turn back out of a dead end rather
+// than walk through its wall.
+
+static constexpr int TICKS = 20'000;
+
+// a loop with one-tile dead ends off its corridors; the ghosts start
+// across the loop from the player
+static constexpr const char* DEAD_END =
+    "; player 1 5\n"
+    "; ghost 11 2\n"
+    "#############\n"
+    "###.#####.###\n"
+    "#...........#\n"
+    "#.####.####.#\n"
+    "#.####.####.#\n"
+    "#...........#\n"
+    "######.######\n"
+    "#############\n";
+
+// true if they agree on every tick of the first game
+static bool matches(const std::string& level, std::uint64_t seed)
+{
+    SplitMix64 seeder{seed};
+    Simulation sim(level, seeder());
+    BatchEnv   env(level, 1, seed, 1);
+
+    std::mt19937 bot{unsigned(seed)};
+    std::uniform_int_distribution<int> pick(0, 4);     // None too, so the player stops
+    Dir dir = Dir::None;
+    int t = 0;
+    for (; t < TICKS && !sim.finished(); ++t) {
+        if (t % (Simulation::TICK_HZ / 4) == 0) dir = static_cast<Dir>(pick(bot));
+        sim.step(Input{dir, false});
+        env.step(&dir);
+
+        bool same = sim.player().position() == Fixed2{env.playerX()[0], env.playerY()[0]}
+                 && sim.score() == env.score(0) && sim.lives() == env.lives(0)
+                 && sim.finished() == env.done(0);
+        bool inside = true;
+        for (int k = 0; k < BatchEnv::GHOSTS; ++k) {
+            const Fixed2 g = sim.ghosts()[std::size_t(k)].position();
+            same   = same && g == Fixed2{env.ghostX()[k], env.ghostY()[k]};
+            inside = inside && canOccupy(sim.level(), g);
+        }
+        if (!same || !inside) {
+            std::cout << level << ", seed " << seed << ": " << (same ? "a ghost left the maze" : "diverged")
+                      << " at tick " << t + 1 << '\n';
+            return false;
+        }
+    }
+    std::cout << level << ", seed " << seed << ": " << t << " ticks identical\n";
+    return true;
+}
+
+int main()
+{
+    const std::string deadEnd = (std::filesystem::temp_directory_path() / "pacman_dead_end.txt").string();
+    std::ofstream(deadEnd) << DEAD_END;
+
+    bool ok = true;
+    for (std::uint64_t seed = 1; seed <= 8; ++seed) ok &= matches("level1", seed);
+    for (std::uint64_t seed = 1; seed <= 4; ++seed) ok &= matches(deadEnd, seed);
+    std::filesystem::remove(deadEnd);
+    if (!ok) std::cout << "FAIL: BatchEnv and Simulation disagree\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include "GameState.hpp"
+#include "Simulation.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Simulation::restore refuses a GameState the session cannot hold, as
+// save() does, instead of writing past its ghosts; and a snapshot it can
+// hold restores the exact state, which the checksum tells apart from one
+// that differs only in a heading.
+
+// an open w x h room, more pellet words than a GameState holds
+static Level room(int w, int h)
+{
+    std::string text = "; player 1 1\n; ghost 2 2\n";
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) text += x == 0 || y == 0 || x == w - 1 || y == h - 1 ? '#' : '.';
+        text += '\n';
+    }
+    return Level::fromText(text, "room");
+}
+
+static bool refused(const char* name, Simulation& sim, const GameState& s)
+{
+    const std::uint64_t before = sim.checksum();
+    try {
+        sim.restore(s);
+    } catch (const std::runtime_error& e) {
+        const bool untouched = sim.checksum() == before;
+        std::cout << name << ": refused (" << e.what() << ")" << (untouched ? "" : ", but changed the state") << '\n';
+        return untouched;
+    }
+    std::cout << name << ": restored a snapshot it cannot hold\n";
+    return false;
+}
+
+int main()
+{
+    Simulation classic("level1", 1);
+    for (int t = 0; t < 300; ++t) classic.step(Input{Dir::Left, false});
+    GameState s{};
+    classic.save(s);
+    const std::uint64_t saved = classic.checksum();
+    for (int t = 0; t < 300; ++t) classic.step(Input{Dir::Up, false});
+    classic.restore(s);
+
+    bool ok = classic.checksum() == saved;
+    std::cout << "level1: " << (ok ? "restored" : "restore MISMATCH") << '\n';
+
+    // a state that differs only in a heading must not hash the same
+    GameState turned = s;
+    turned.ghosts[0].curDir = opposite(turned.ghosts[0].curDir);
+    classic.restore(turned);
+    const bool seen = classic.checksum() != saved;
+    std::cout << "level1: a reversed ghost " << (seen ? "changes" : "does NOT change") << " the checksum\n";
+    ok &= seen;
+
+    Simulation fewer("level1", 1, 2);
+    ok &= refused("2 ghosts", fewer, s);
+    Simulation more("level1", 1, 8);
+    ok &= refused("8 ghosts", more, s);
+    Simulation big(room(64, 40), 1);
+    ok &= refused("64x40 room", big, s);
+
+    if (!ok) std::cout << "FAIL: snapshot restore\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include "AllocCounter.hpp"
+#include "GameState.hpp"
+#include "SimSnapshot.hpp"
+#include "Simulation.hpp"
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+// runs the simulation thread's per-tick work (step, snapshot capture, the
+// rewind ring) for 10,000 ticks after a warm-up and fails if any of it
+// allocates. Each case is one code path: the classic game, a many-ghost
+// run with the spatial hash, and a maze that needs the cluster hierarchy.
+
+static constexpr int WARMUP = 2'000;
+static constexpr int TICKS  = 10'000;
+
+// a w x h grid of pillars, big enough that ghosts use PathHierarchy
+static Level gridMaze(int w, int h)
+{
+    std::string text = "; player 1 1\n; ghost " + std::to_string(w / 2 | 1) + " " + std::to_string(h / 2 | 1) + "\n";
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            bool wall = x == 0 || y == 0 || x == w - 1 || y == h - 1 || (x % 2 == 0 && y % 2 == 0);
+            text += wall ? '#' : '.';
+        }
+        text += '\n';
+    }
+    return Level::fromText(text, "grid");
+}
+
+// true if the measured ticks allocated nothing
+static bool run(const char* name, Simulation& sim)
+{
+    const bool rewindable = sim.ghosts().size() == Simulation::GHOSTS
+        && sim.level().bitboardWords() <= GameState::MAX_PELLET_WORDS;
+    using Rewind = RewindRing<Simulation::TICK_HZ * 10>;
+    auto      rewind = std::make_unique<Rewind>();
+    GameState state{};
+    SimSnapshot s;
+    s.reserve(sim);
+
+    std::mt19937 bot(7);
+    std::uniform_int_distribution<int> pick(1, 4);
+    Input in;
+    std::uint64_t before = 0;
+    unsigned games = 0;
+    for (int t = 0; t < WARMUP + TICKS; ++t) {
+        if (t == WARMUP) before = alloccount::allocations();
+        if (t % (Simulation::TICK_HZ / 2) == 0) in.dir = static_cast<Dir>(pick(bot));
+        in.restart = sim.finished();
+        games += in.restart;
+        s.captureBefore(sim);
+        // now and then walk back a second, as holding Backspace does
+        if (rewindable && t % 900 >= 840) {
+            if (rewind->pop(state)) sim.restore(state);
+        } else {
+            sim.step(in);
+            if (rewindable) {
+                sim.save(state);
+                rewind->push(state);
+            }
+        }
+        s.captureAfter(sim, 0);
+    }
+    const std::uint64_t n = alloccount::allocations() - before;
+    std::cout << name << ": " << n << " allocations in " << TICKS << " ticks ("
+              << games << " restarts)\n";
+    return n == 0;
+}
+
+int main()
+{
+    bool ok = true;
+    {
+        Simulation sim("level1", 1);
+        ok &= run("level1", sim);
+    }
+    {
+        Simulation sim("level1", 2, 64);
+        sim.setCollisionMode(CollisionMode::SpatialHash);
+        ok &= run("level1, 64 ghosts, hash", sim);
+    }
+    {
+        Simulation sim(gridMaze(101, 81), 3);
+        ok &= run("101x81 grid, cluster hierarchy", sim);
+    }
+    if (!ok) std::cout << "FAIL: the steady-state tick allocates\n";
+    return ok ? 0 : 1;
+}
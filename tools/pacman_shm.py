@@ -0,0 +1,144 @@
+"""Agent side of `PacManHeadless --shm NAME`: maps the observation ring
+described in src/ShmEnv.hpp and plays the game from Python.
+
+    env = PacManShm("pacman")
+    while (obs := env.observe()) is not None:
+        env.act(policy(obs.planes, obs.player, obs.ghosts))
+
+Actions are 0 none, 1 left, 2 right, 3 up, 4 down. An observation reads
+the shared memory in place and stays valid for `env.slots` steps. With
+numpy installed, `obs.planes` is a (4, height, width) uint8 array over
+that memory (WALLS, PELLETS, PLAYER, GHOSTS); without it, a memoryview.
+Linux only: waiting sleeps on a futex.
+"""
+import ctypes
+import mmap
+import os
+import platform
+import struct
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+MAGIC, VERSION = 0x4F4D4350, 1
+WALLS, PELLETS, PLAYER, GHOSTS = range(4)
+NONE, LEFT, RIGHT, UP, DOWN = range(5)
+
+_HEADER = struct.Struct("<11I")           # magic .. planeOffset
+_SLOT = struct.Struct("<QIiBB6xii")       # tick score lives done action, player x y
+_ACTION = 17                              # offset of Slot::action
+# Header words, in uint32 units
+_OBS_SEQ, _OBS_SLEEPERS, _ACT_SEQ, _CLOSED = 16, 17, 32, 48
+
+_SPIN = 2000 if (os.cpu_count() or 1) > 1 else 0
+_SYS_FUTEX = {"x86_64": 202, "aarch64": 98}[platform.machine()]
+_FUTEX_WAIT, _FUTEX_WAKE = 0, 1
+_libc = ctypes.CDLL(None, use_errno=True)
+
+
+class _Timespec(ctypes.Structure):
+    _fields_ = [("tv_sec", ctypes.c_long), ("tv_nsec", ctypes.c_long)]
+
+
+_TIMEOUT = _Timespec(0, 100_000_000)
+
+
+class Observation:
+    __slots__ = ("tick", "score", "lives", "done", "player", "ghosts", "planes")
+
+
+class PacManShm:
+    def __init__(self, name):
+        fd = os.open("/dev/shm/" + name.lstrip("/"), os.O_RDWR)
+        try:
+            self._mm = mmap.mmap(fd, 0)
+        finally:
+            os.close(fd)
+        (magic, version, self.width, self.height, self.slots, self.ghosts, self.tile_units,
+         self._slot_offset, self._slot_bytes, self._ghost_offset, self._plane_offset) = _HEADER.unpack_from(self._mm)
+        if magic != MAGIC or version != VERSION:
+            raise RuntimeError(name + " is not a ready PacMan environment")
+        self._words = (ctypes.c_uint32 * 64).from_buffer(self._mm)
+        self._addr = ctypes.addressof(self._words)
+        self._ghosts = struct.Struct("<%di" % (2 * self.ghosts))
+        self._seen = self._words[_ACT_SEQ]
+
+    def _slot(self, k):
+        return self._slot_offset + k % self.slots * self._slot_bytes
+
+    def _wait(self, target):
+        w = self._words
+        for _ in range(_SPIN):
+            if (w[_OBS_SEQ] - target) & 0x80000000 == 0:
+                return True
+            if w[_CLOSED]:
+                return False
+        while True:
+            w[_OBS_SLEEPERS] += 1          # only this side writes it
+            v = w[_OBS_SEQ]
+            reached = (v - target) & 0x80000000 == 0
+            if not reached and not w[_CLOSED]:
+                _libc.syscall(_SYS_FUTEX, ctypes.c_void_p(self._addr + 4 * _OBS_SEQ), _FUTEX_WAIT,
+                              ctypes.c_uint32(v), ctypes.byref(_TIMEOUT), None, 0)
+            w[_OBS_SLEEPERS] -= 1
+            if reached:
+                return True
+            if w[_CLOSED]:
+                return (w[_OBS_SEQ] - target) & 0x80000000 == 0
+
+    def observe(self):
+        """The next observation, None once the environment is gone."""
+        if not self._wait((self._seen + 1) & 0xFFFFFFFF):
+            return None
+        base = self._slot(self._seen)
+        self._seen += 1
+        o = Observation()
+        o.tick, o.score, o.lives, done, _, px, py = _SLOT.unpack_from(self._mm, base)
+        o.done = bool(done)
+        o.player = (px, py)
+        g = self._ghosts.unpack_from(self._mm, base + self._ghost_offset)
+        o.ghosts = list(zip(g[0::2], g[1::2]))
+        start = base + self._plane_offset
+        if numpy is not None:
+            o.planes = numpy.frombuffer(self._mm, numpy.uint8, 4 * self.width * self.height,
+                                        start).reshape(4, self.height, self.width)
+        else:
+            o.planes = memoryview(self._mm)[start:start + 4 * self.width * self.height]
+        return o
+
+    def act(self, action):
+        """Answers the last observation."""
+        self._mm[self._slot(self._seen - 1) + _ACTION] = action & 7
+        self._words[_ACT_SEQ] = self._seen & 0xFFFFFFFF
+        # always wake: a plain store then a load of the sleeper count could
+        # be reordered, and the wake costs less than a missed one
+        _libc.syscall(_SYS_FUTEX, ctypes.c_void_p(self._addr + 4 * _ACT_SEQ), _FUTEX_WAKE, 1, None, None, 0)
+
+    def close(self):
+        self._words[_CLOSED] = 1
+        for word in (_OBS_SEQ, _ACT_SEQ):
+            _libc.syscall(_SYS_FUTEX, ctypes.c_void_p(self._addr + 4 * word), _FUTEX_WAKE, 1, None, None, 0)
+        del self._words
+        try:
+            self._mm.close()
+        except BufferError:
+            pass                            # unmapped with the last observation still held
+
+
+if __name__ == "__main__":
+    import random
+    import sys
+    import time
+
+    env = PacManShm(sys.argv[1] if len(sys.argv) > 1 else "pacman")
+    steps, action, t0 = 0, NONE, time.perf_counter()
+    while steps < 200_000 and (obs := env.observe()) is not None:
+        if steps % 30 == 0:
+            action = random.randint(LEFT, DOWN)
+        env.act(action)
+        steps += 1
+    secs = time.perf_counter() - t0
+    env.close()
+    print("steps %d, %.0f steps/sec" % (steps, steps / secs))